@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <memory_resource>
+
+// 单回合分配区：分析器的临时容器从这里取内存，回合结束时整体释放，期间的释放操作均为空操作
+// 某回合用量超出缓冲区时，超出部分临时向全局分配器申请，并在整体释放时据此扩大缓冲区，
+// 因此用量稳定后每回合不再调用全局分配器
+// 注意：从这里分配的容器不能存活到`release`之后，跨回合保存的数据应当复制到默认资源上
+class Turn_arena {
+public:
+    // 初始缓冲区大小
+    static constexpr size_t INITIAL_SIZE = 1 << 20;
+
+    Turn_arena() noexcept { reserve(INITIAL_SIZE); }
+    Turn_arena(const Turn_arena&) = delete;
+    Turn_arena& operator=(const Turn_arena&) = delete;
+
+    // 供`std::pmr`容器使用的内存资源
+    std::pmr::memory_resource* resource() noexcept { return &*pool; }
+
+    // 当前缓冲区大小
+    size_t capacity() const noexcept { return buffer_size; }
+
+    // 整体释放本回合的所有分配，并按需扩大缓冲区
+    void release() noexcept {
+        if (!overflow.allocated) {
+            pool->release();
+            return;
+        }
+        reserve(buffer_size + overflow.allocated);
+        overflow.allocated = 0;
+    }
+
+private:
+    // 记录溢出量的上游资源
+    class __Overflow_resource : public std::pmr::memory_resource {
+    public:
+        size_t allocated = 0;
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            allocated += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    size_t buffer_size = 0;
+    std::unique_ptr<std::byte[]> buffer;
+    __Overflow_resource overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> pool;
+
+    void reserve(size_t size) noexcept {
+        pool.reset();
+        buffer.reset(new std::byte[size]);
+        buffer_size = size;
+        pool.emplace(buffer.get(), size, &overflow);
+    }
+};
+
+Turn_arena turn_arena;
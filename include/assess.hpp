@@ -5,7 +5,9 @@
 #include <cstring>
 #include <iostream>
 #include <optional>
+#include <memory_resource>
 
+#include "arena.hpp"
 #include "gamestate.hpp"
 #include "controller.hpp"
 
@@ -58,9 +60,9 @@ public:
 
     /**
      * @brief 计算从`pos`走向`origin`的完整路径，包括`pos`和`origin`本身
-     * @note 本方法断言能够从`pos`走到`origin`
+     * @note 本方法断言能够从`pos`走到`origin`，返回的路径分配在单回合分配区上
      */
-    std::vector<Coord> path_to_origin(const Coord& pos) const noexcept;
+    std::pmr::vector<Coord> path_to_origin(const Coord& pos) const noexcept;
 
     // 不考虑地形地计算`pos`到某个将领坐标`general_pos`的有效距离，以0为恰好安全
     static int effect_dist(const Coord& pos, const Coord& general_pos, bool can_rush, int movement_val) noexcept;
@@ -233,18 +235,77 @@ struct Attack_info {
     Attack_info(Coord origin, const Critical_tactic& tactic, bool pure_army_attack, const std::vector<Operation>& ops) noexcept :
         origin(origin), tactic(tactic), pure_army_attack(pure_army_attack), ops(ops) {}
 };
+// 攻击搜索结果缓存：以局面哈希、攻击方与额外油量为键的定长直接映射表
+// 替换策略为“新结果总是覆盖同槽位的旧结果”；局面哈希不含回合数，故跨回合的相同局面同样可以命中
+// 局面哈希包含地形，同一进程换地图后旧表项不会误命中，无需清空
+class Attack_cache {
+public:
+    // 表项数，须为2的幂
+    static constexpr int SIZE = 1 << 12;
+
+    // 命中与未命中次数
+    int hit_count;
+    int miss_count;
+
+    Attack_cache() noexcept : hit_count(0), miss_count(0), entries(SIZE) {}
+
+    // 计算缓存键值
+    static uint64_t make_key(const GameState& state, int attacker_seat, int extra_oil) noexcept {
+        uint64_t params = (uint64_t(uint32_t(extra_oil)) << 16) ^ (uint64_t(attacker_seat) << 8) ^ uint64_t(my_seat);
+        return state.zobrist ^ zobrist_mix(params + 0x2545f4914f6cdd1dULL);
+    }
+    // 查找缓存，未命中时返回nullptr
+    const std::optional<Attack_info>* find(uint64_t key) noexcept {
+        const Entry& entry = entries[key & (SIZE - 1)];
+        if (entry.valid && entry.key == key) {
+            ++hit_count;
+            return &entry.result;
+        }
+        ++miss_count;
+        return nullptr;
+    }
+    // 写入缓存，返回缓存中的结果
+    const std::optional<Attack_info>& store(uint64_t key, std::optional<Attack_info>&& result) noexcept {
+        Entry& entry = entries[key & (SIZE - 1)];
+        entry.valid = true;
+        entry.key = key;
+        entry.result = std::move(result);
+        return entry.result;
+    }
+    // 清空缓存与计数；正确性不依赖清空，仅用于丢弃旧表项或重新统计命中率（如每局开始时）
+    void clear() noexcept {
+        for (Entry& entry : entries) entry.valid = false;
+        hit_count = miss_count = 0;
+    }
+
+private:
+    struct Entry {
+        bool valid = false;
+        uint64_t key = 0;
+        std::optional<Attack_info> result;
+    };
+    std::vector<Entry> entries;
+};
+
 // 攻击搜索器
 class Attack_searcher {
 public:
+    // 所有攻击搜索器共享的结果缓存
+    inline static Attack_cache cache{};
+
     // 指定攻击搜索器的阵营和基于的状态
     Attack_searcher(int attacker_seat, const GameState& state) noexcept : attacker_seat(attacker_seat), state(state) {}
-    // 利用攻击搜索器进行一次完整的单将攻击搜索，仅返回一个结果
-    std::optional<Attack_info> search(int extra_oil = 0) const noexcept;
+    // 利用攻击搜索器进行一次完整的单将攻击搜索，仅返回一个结果，找不到时返回nullptr；相同局面与参数的结果会被缓存
+    // 返回的结果存放在缓存中，同一槽位被之后的搜索覆盖前有效，需要跨搜索保留时应自行复制
+    const Attack_info* search(int extra_oil = 0) const noexcept;
 
 private:
     const int attacker_seat;
     const GameState& state;
 
+    // 不经缓存的实际搜索
+    std::optional<Attack_info> __search(int extra_oil) const noexcept;
+
 
     // 技能释放的类型
     class Discharge_type {
@@ -319,7 +380,7 @@ struct Move_plan {
     double target_distance_cost;
 
     Move_plan(Coord destination, int player) noexcept :
-        destination(destination), ops(player), step_count(0), step_cost(0), desert_cost(0), target_distance_cost(0) {}
+        destination(destination), ops(player, turn_arena.resource()), step_count(0), step_cost(0), desert_cost(0), target_distance_cost(0) {}
 
     bool operator< (const Move_plan& other) const noexcept { return ops.score < other.ops.score; }
     bool operator> (const Move_plan& other) const noexcept { return ops.score > other.ops.score; }
@@ -354,8 +415,8 @@ public:
     // 参数设置函数
     General_mover& operator<< (const Move_cost_cfg& cfg) noexcept { cost_cfg = cfg; return *this; }
 
-    // 进行寻路搜索
-    std::vector<Move_plan> search() const noexcept;
+    // 进行寻路搜索，结果分配在单回合分配区上
+    std::pmr::vector<Move_plan> search() const noexcept;
 
 private:
     const GameState& state;
@@ -416,7 +477,8 @@ public:
     // 发起行动的根据地，如果是从主将上分兵则为nullptr
     const Militia_area* area;
     // 行动方案，每一个元素均为一个“从A出发，向dir方向移动”的操作
-    std::vector<std::pair<Coord, Direction>> plan;
+    // 由分析器产生的方案分配在单回合分配区上，复制构造的副本则使用默认资源，可以跨回合保存
+    std::pmr::vector<std::pair<Coord, Direction>> plan;
 
     // 需要的军队数量
     int army_used;
@@ -424,15 +486,15 @@ public:
     int gather_steps;
 
     // 构造函数：通过`calc_gather_plan`计算出结果构造
-    Militia_plan(const Generals* target, const Militia_area* area, const std::vector<std::pair<Coord, Direction>>& plan, int army_used) noexcept :
-        target(target), target_pos(target->position), area(area), plan(plan), army_used(army_used), gather_steps(this->plan.size()) {}
+    Militia_plan(const Generals* target, const Militia_area* area, std::pmr::vector<std::pair<Coord, Direction>>&& plan, int army_used) noexcept :
+        target(target), target_pos(target->position), area(area), plan(std::move(plan)), army_used(army_used), gather_steps(this->plan.size()) {}
 };
 
 // 民兵分析器
 class Militia_analyzer {
 public:
-    // 根据地列表
-    std::vector<Militia_area> areas;
+    // 根据地列表，分配在单回合分配区上
+    std::pmr::vector<Militia_area> areas;
 
     // 指定当前状态并进行分析
     Militia_analyzer(const GameState& state) noexcept;
@@ -452,17 +514,15 @@ private:
     const GameState& state;
 
     mutable bool vis[Constant::col][Constant::row];
-    // 对`areas`中最后一个根据地进行DFS
-    void analyzer_dfs(const Coord& coord) noexcept;
 
     /**
      * @brief 计算应当如何从`info`中的根据地汇集军队至`info.clostest_point`
      * @param info 指定的根据地及其距离信息
      * @param required_army 需要的军队数量
      * @param max_steps 最大步数，若填写此参数则忽略`required_army`
-     * @return std::pair<int, std::vector<std::pair<Coord, Direction>>> 第一个元素为实际使用士兵数，第二个元素为行动方案
+     * @return std::pair<int, std::pmr::vector<std::pair<Coord, Direction>>> 第一个元素为实际使用士兵数，第二个元素为行动方案
      */
-    std::pair<int, std::vector<std::pair<Coord, Direction>>> calc_gather_plan(const Militia_dist_info& info, int required_army, int max_steps = -1) const noexcept;
+    std::pair<int, std::pmr::vector<std::pair<Coord, Direction>>> calc_gather_plan(const Militia_dist_info& info, int required_army, int max_steps = -1) const noexcept;
 
     struct __Queue_Node {
         Coord coord;
@@ -485,7 +545,8 @@ Dist_map::Dist_map(const GameState& board, const Coord& origin, const Path_find_
     std::fill_n(reinterpret_cast<double*>(dist), col * row, MAX_DIST + 1);
 
     // 单源最短路
-    std::priority_queue<__Queue_Node, std::vector<__Queue_Node>, std::greater<__Queue_Node>> queue;
+    std::priority_queue<__Queue_Node, std::pmr::vector<__Queue_Node>, std::greater<__Queue_Node>> queue{
+        std::greater<__Queue_Node>(), std::pmr::vector<__Queue_Node>(turn_arena.resource())};
     queue.emplace(origin, 0);
     while (!queue.empty()) {
         __Queue_Node node = queue.top();
@@ -498,7 +559,7 @@ Dist_map::Dist_map(const GameState& board, const Coord& origin, const Path_find_
         dist[curr_pos.x][curr_pos.y] = node.dist;
 
         // 不能走的格子不允许扩展
-        if (cfg.general_path && board[curr_pos].generals != nullptr && curr_pos != origin) continue; // 将领所在格
+        if (cfg.general_path && board[curr_pos].has_general() && curr_pos != origin) continue; // 将领所在格
 
         // 扩展
         for (const Coord& dir : DIRECTION_ARR) {
@@ -520,7 +581,7 @@ Direction Dist_map::direction_to_origin(const Coord& pos) const noexcept {
     for (int i = 0; i < 4; ++i) {
         Coord next_pos = pos + DIRECTION_ARR[i];
         if (!next_pos.in_map()) continue;
-        if (cfg.general_path && next_pos != origin && board[next_pos].generals != nullptr) continue;
+        if (cfg.general_path && next_pos != origin && board[next_pos].has_general()) continue;
 
         double next_dist = dist[next_pos.x][next_pos.y] + board[next_pos].army * 1e-6 * ((board[next_pos].player != my_seat) ? 1 : -1);
         if (next_dist < min_dist) {
@@ -531,17 +592,18 @@ Direction Dist_map::direction_to_origin(const Coord& pos) const noexcept {
     assert(min_dist <= MAX_DIST);
     return static_cast<Direction>(min_dir);
 }
-std::vector<Coord> Dist_map::path_to_origin(const Coord& pos) const noexcept {
+std::pmr::vector<Coord> Dist_map::path_to_origin(const Coord& pos) const noexcept {
     assert(pos.in_map());
     assert(dist[pos.x][pos.y] <= MAX_DIST);
 
-    std::vector<Coord> path{pos};
+    std::pmr::vector<Coord> path({pos}, turn_arena.resource());
     for (Coord curr_pos = pos; curr_pos != origin; ) {
         Direction dir = direction_to_origin(curr_pos);
         curr_pos += DIRECTION_ARR[dir];
         path.push_back(curr_pos);
 
-        if (path.size() >= 50) {
+        // 沿距离递减方向回溯不会重复经过格子，路径长度超过格子总数说明距离矩阵有误
+        if (path.size() > col * row) {
             logger.log(LOG_LEVEL_ERROR, "path_to_origin: path too long");
             for (const Coord& coord : path) logger.log(LOG_LEVEL_ERROR, "\t%s", coord.str().c_str());
             assert(false);
@@ -567,7 +629,14 @@ int Dist_map::effect_dist(const Coord& pos, const Coord& general_pos, bool can_r
 
 std::vector<Attack_searcher::Skill_discharger> Attack_searcher::skill_table = {};
 
-std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept {
+const Attack_info* Attack_searcher::search(int extra_oil) const noexcept {
+    uint64_t key = Attack_cache::make_key(state, attacker_seat, extra_oil);
+    const std::optional<Attack_info>* cached = cache.find(key);
+    if (!cached) cached = &cache.store(key, __search(extra_oil));
+    return *cached ? &**cached : nullptr;
+}
+
+std::optional<Attack_info> Attack_searcher::__search(int extra_oil) const noexcept {
     static std::vector<int> army_left{};
     static std::vector<Coord> landing_points{};
     static std::vector<Operation> attack_ops{};
@@ -576,16 +645,16 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
     int oil = state.coin[attacker_seat] + extra_oil;
     bool enemy_extra_army = (attacker_seat != my_seat && attacker_seat == 0);
     int attacker_mobility = state.tech_level[attacker_seat][static_cast<int>(TechType::MOBILITY)];
-    const MainGenerals* enemy_general = dynamic_cast<const MainGenerals*>(state.generals[1 - attacker_seat]);
+    const Generals* enemy_general = state.main_general(1 - attacker_seat);
+    assert(enemy_general->type == GeneralType::MAIN_GENERAL);
     if (!state.can_soldier_step_on(enemy_general->position, attacker_seat)) return std::nullopt; // 排除敌方主将在沼泽而走不进的情况
 
     Dist_map enemy_dist(state, enemy_general->position, Path_find_config(1.0, state.has_swamp_tech(attacker_seat), false));
 
     // 计算“已经释放的技能”的价值
     int current_skill_value = 0;
-    for (int i = 0, siz = state.generals.size(); i < siz; ++i) {
-        const Generals* general = state.generals[i];
-        if (general->player != attacker_seat || dynamic_cast<const OilWell*>(general) != nullptr) continue;
+    for (const Generals* general : state.generals.in(state.generals.of_player(attacker_seat))) {
+        if (general->type == GeneralType::OIL_WELL) continue;
 
         if (general->skill_active(SkillType::COMMAND)) current_skill_value += GENERAL_SKILL_COST[SkillType::COMMAND];
         if (general->skill_active(SkillType::WEAKEN)) current_skill_value += GENERAL_SKILL_COST[SkillType::WEAKEN];
@@ -605,17 +674,18 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
     int atks_till_check_discharger = 0;
 
     // 用于纯民兵攻击的假定将领
-    SubGenerals fake_general{-1, attacker_seat, state.generals[1-attacker_seat]->position};
+    Generals fake_general{GeneralType::SUB_GENERAL, -1, attacker_seat, state.main_general(1-attacker_seat)->position};
     fake_general.mobility_level = fake_general.produce_level = fake_general.defence_level = 0;
     std::fill_n(fake_general.skills_cd, GENERAL_SKILL_COUNT, 10);
 
     // 对每个将领
     for (int i = 0, siz = state.generals.size(); i < siz; ++i) {
         const Generals* general = state.generals[i];
+        if (!general->alive) continue;
         bool pure_army_attack = (general->id == 1-attacker_seat); // 是否为纯民兵攻击
 
         if (!pure_army_attack) {
-            if (general->player != attacker_seat || dynamic_cast<const OilWell*>(general) != nullptr) continue;
+            if (general->player != attacker_seat || general->type == GeneralType::OIL_WELL) continue;
             if (state[general->position].army <= 1) continue;
         } else general = &fake_general;
 
@@ -649,7 +719,7 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
             for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
                 Coord pos{x, y};
                 if (gather_dist[pos] > attacker_mobility || state[pos].player != attacker_seat || state[pos].army <= 1) continue;
-                if (state[pos].generals && !dynamic_cast<const OilWell*>(state[pos].generals)) continue; // 排除主副将
+                if (state[pos].has_general() && state.general_at(pos)->type != GeneralType::OIL_WELL) continue; // 排除主副将
 
                 gather_points.emplace_back(pos, 0);
             }
@@ -688,7 +758,7 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
 
             // 对每个落地点计算能否攻下
             for (const Coord& landing_point : landing_points) {
-                std::vector<Coord> path{enemy_dist.path_to_origin(landing_point)};
+                std::pmr::vector<Coord> path = enemy_dist.path_to_origin(landing_point);
                 if (tactic.can_rush) path.insert(path.begin(), gather_point);
                 if (gather.army_steps) path.insert(path.begin(), general->position); // 需要将军队移动到汇合点
 
@@ -755,36 +825,35 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
                 // 重新计算技能释放表（考虑将领位置）
                 skill_table.clear();
                 Coord atk_pos = path[path.size() - 2]; // 统率位置
-                int x_min = std::max(atk_pos.x - (GENERAL_ATTACK_RADIUS + 1), 0);
-                int x_max = std::min(atk_pos.x + (GENERAL_ATTACK_RADIUS + 1), Constant::col - 1);
-                int y_min = std::max(atk_pos.y - (GENERAL_ATTACK_RADIUS + 1), 0);
-                int y_max = std::min(atk_pos.y + (GENERAL_ATTACK_RADIUS + 1), Constant::row - 1);
-                for (int x = x_min; x <= x_max; ++x) for (int y = y_min; y <= y_max; ++y) {
-                    Coord pos{x, y};
-                    Discharge_type can_command = pos.in_attack_range(atk_pos) ? Discharge_type::NORMAL : Discharge_type::UNABLE;
-                    Discharge_type can_cover_enemy = pos.in_attack_range(enemy_general->position) ? Discharge_type::NORMAL : Discharge_type::UNABLE;
-                    if (!can_command && !can_cover_enemy) continue; // 啥都不能干的格子
+                Bitboard command_range = Bitboard::square(atk_pos, GENERAL_ATTACK_RADIUS);
+                Bitboard cover_range = Bitboard::square(enemy_general->position, GENERAL_ATTACK_RADIUS);
+                // 只考虑统率位置附近的格子，排除啥都不能干的格子
+                Bitboard candidates = (command_range | cover_range) & Bitboard::square(atk_pos, GENERAL_ATTACK_RADIUS + 1);
+                candidates.for_each([&](int bit) {
+                    Coord pos = Bitboard::coord(bit);
+                    Discharge_type can_command = command_range.test(bit) ? Discharge_type::NORMAL : Discharge_type::UNABLE;
+                    Discharge_type can_cover_enemy = cover_range.test(bit) ? Discharge_type::NORMAL : Discharge_type::UNABLE;
 
                     // 确认格子上的将领
                     // landing_point处会出现general，而general原位置的general需要忽略
-                    const Generals* cell_general = state[pos].generals;
+                    const Generals* cell_general = state.general_at(pos);
                     if (pos == landing_point) cell_general = general;
                     else if (pos == general->position) cell_general = nullptr;
-                    if (cell_general && cell_general->id < 0) cell_general = state[landing_point].generals; // 虚拟将领不能释放技能
+                    if (cell_general && cell_general->id < 0) cell_general = state.general_at(landing_point); // 虚拟将领不能释放技能
 
-                    if (cell_general && dynamic_cast<const OilWell*>(cell_general)) continue; // 油井无法利用
+                    if (cell_general && cell_general->type == GeneralType::OIL_WELL) return; // 油井无法利用
                     if (cell_general) { // 有将领（主将或副将）
                         // 阵营检查
-                        if (cell_general->player != attacker_seat) continue;
+                        if (cell_general->player != attacker_seat) return;
                         // 冷却检查
                         if (can_command) {
                             if (cell_general->skill_active(SkillType::COMMAND)) can_command = Discharge_type::ALREADY_ACTIVE;
-                            else if (cell_general->cd(SkillType::COMMAND)) continue;
+                            else if (cell_general->cd(SkillType::COMMAND)) return;
                         }
                         if (can_cover_enemy) {
-                            if (cell_general->cd(SkillType::STRIKE)) continue; // 【此处也排除了“能够弱化但不能空袭”的情形】
+                            if (cell_general->cd(SkillType::STRIKE)) return; // 【此处也排除了“能够弱化但不能空袭”的情形】
                             if (cell_general->skill_active(SkillType::WEAKEN)) can_cover_enemy = Discharge_type::ALREADY_ACTIVE;
-                            else if (cell_general->cd(SkillType::WEAKEN)) continue;
+                            else if (cell_general->cd(SkillType::WEAKEN)) return;
                         }
                         skill_table.emplace_back(pos, cell_general, can_command, can_cover_enemy);
                     }
@@ -793,10 +862,10 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
                         // 在(landing_point, attack_pos]范围中的格子可跳过阵营检查
                         bool bypass_team = std::find(path.begin() + (tactic.can_rush ? 2 : 1), path.end() - 1, pos) != (path.end() - 1);
                         // 阵营检查（隐含了地形）
-                        if (state[pos].player != attacker_seat && !bypass_team) continue;
+                        if (state[pos].player != attacker_seat && !bypass_team) return;
                         skill_table.emplace_back(pos, nullptr, can_command, can_cover_enemy);
                     }
-                }
+                });
 
                 // 排序技能释放表
                 std::sort(skill_table.begin(), skill_table.end(), std::greater<Skill_discharger>());
@@ -863,12 +932,12 @@ std::optional<Attack_info> Attack_searcher::search(int extra_oil) const noexcept
 
 // **************************************** 移动搜索实现 ****************************************
 
-std::vector<Move_plan> General_mover::search() const noexcept {
+std::pmr::vector<Move_plan> General_mover::search() const noexcept {
     static std::vector<int> army_left{};
 
     // 参数初始化
-    std::vector<Move_plan> ret;
-    bool main_general = dynamic_cast<const MainGenerals*>(gen_to_move);
+    std::pmr::vector<Move_plan> ret(turn_arena.resource());
+    bool main_general = gen_to_move->type == GeneralType::MAIN_GENERAL;
     int extra_oil = main_general ? (state.calc_oil_production(1-my_seat) * 2) : (50 - state.coin[1-my_seat]); // 额外的油量（认为对方只用50油打副将）
     std::optional<Dist_map> target_dist = target_pos ? std::make_optional<Dist_map>(state, *target_pos, path_cfg) : std::nullopt;
 
@@ -883,9 +952,16 @@ std::vector<Move_plan> General_mover::search() const noexcept {
         avail_terminals.push_back(pos);
     }
 
+    // 模拟执行用的状态只复制一次，每个方案执行后通过撤销日志回滚；与日志一样静态存放，避免大地图下占用栈
+    static Undo_journal journal{};
+    static GameState temp_state;
+    temp_state.copy_as(state);
+    journal.clear();
+    temp_state.attach_journal(&journal);
+
     // 对范围内的每个格子单独考虑
     for (const Coord& terminal : avail_terminals) {
-        std::vector<Coord> path{general_dist.path_to_origin(terminal)};
+        std::pmr::vector<Coord> path = general_dist.path_to_origin(terminal);
         std::reverse(path.begin(), path.end());
 
         army_left.clear();
@@ -924,17 +1000,18 @@ std::vector<Move_plan> General_mover::search() const noexcept {
             move_plan.ops += Operation::move_generals(gen_to_move->id, terminal);
 
         // 然后开始计算安全性
-        GameState temp_state;
-        temp_state.copy_as(state);
         bool exec_pass = execute_operations(temp_state, move_plan.ops);
         if (!exec_pass) {
+            temp_state.undo(journal.op_count());
             logger.log(LOG_LEVEL_ERROR, "\t\tMove plan execution failed, ops:");
             for (const Operation& op : move_plan.ops) logger.log(LOG_LEVEL_ERROR, "\t\t\t%s", op.str().c_str());
             continue;
         }
 
         Attack_searcher searcher(1-my_seat, temp_state);
-        if (searcher.search(extra_oil)) continue;// 会被攻击则舍弃
+        bool attacked = searcher.search(extra_oil) != nullptr;
+        temp_state.undo(journal.op_count());
+        if (attacked) continue;// 会被攻击则舍弃
 
         // 否则计算各类cost
         move_plan.step_count = path.size() - 1;
@@ -944,7 +1021,7 @@ std::vector<Move_plan> General_mover::search() const noexcept {
         move_plan.ops.score = - (move_plan.desert_cost + move_plan.step_cost + move_plan.target_distance_cost);
 
         logger.log(LOG_LEVEL_DEBUG, "\t\t[Search] New move plan: %s", move_plan.c_str());
-        ret.push_back(move_plan);
+        ret.push_back(std::move(move_plan));
     }
 
     // 排序并输出
@@ -954,18 +1031,27 @@ std::vector<Move_plan> General_mover::search() const noexcept {
 
 // **************************************** 民兵分析器实现 ****************************************
 
-Militia_analyzer::Militia_analyzer(const GameState& state) noexcept : state(state) {
-    // 寻找所有根据地
-    memset(vis, 0, sizeof(vis));
-    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
-        Coord coord(x, y);
-        if (vis[x][y] || state[coord].player != my_seat) continue;
-
-        const Generals* generals = state[coord].generals;
-        if (generals != nullptr && dynamic_cast<const MainGenerals*>(generals)) continue; // 不动主将
-
-        areas.emplace_back();
-        analyzer_dfs(coord);
+Militia_analyzer::Militia_analyzer(const GameState& state) noexcept : areas(turn_arena.resource()), state(state) {
+    // 根据地为己方格子（不动主将）的四连通分量
+    const Board_planes& planes = state.planes;
+    Bitboard remain = planes.owned[my_seat];
+    (remain & planes.occupied).for_each([&](int bit) {
+        Coord pos = Bitboard::coord(bit);
+        if (state.general_at(pos)->type == GeneralType::MAIN_GENERAL) remain.reset(pos);
+    });
+
+    // 每次从下标最小的格子出发洪泛出一个根据地
+    while (remain.any()) {
+        Bitboard component = Bitboard::single(Bitboard::coord(remain.lowest())).flood_fill(remain);
+        remain &= ~component;
+
+        Militia_area& area = areas.emplace_back();
+        area.area = component.count();
+        component.for_each([&](int bit) {
+            Coord pos = Bitboard::coord(bit);
+            area[pos] = true;
+            area.max_army += planes.army[Board_planes::index(pos)] - 1;
+        });
     }
 }
 
@@ -986,7 +1072,7 @@ std::optional<Militia_plan> Militia_analyzer::search_plan_from_militia(const Gen
     Dist_map target_dist(state, target->position, dist_cfg); // 以沙漠为2格计算余量
 
     // 将根据地从近到远排序
-    std::vector<Militia_dist_info> dist_info;
+    std::pmr::vector<Militia_dist_info> dist_info(turn_arena.resource());
     for (const Militia_area& area : areas) {
         // 对每一个根据地计算最近点
         Coord clostest_point;
@@ -1015,11 +1101,11 @@ std::optional<Militia_plan> Militia_analyzer::search_plan_from_militia(const Gen
         if (area.max_army < army_required) continue; // 兵力不足
 
         // 计算方案：从集合点处走到目标点
-        std::vector<Coord> path = target_dist.path_to_origin(info.clostest_point);
+        std::pmr::vector<Coord> path = target_dist.path_to_origin(info.clostest_point);
 
         // 计算方案：兵力汇集到最近点处
-        const auto& gather_plan = calc_gather_plan(info, army_required, support_mode ? max_support_steps - (path.size() - 1) : -1);
-        Militia_plan plan(target, info.area, gather_plan.second, gather_plan.first);
+        auto gather_plan = calc_gather_plan(info, army_required, support_mode ? max_support_steps - (path.size() - 1) : -1);
+        Militia_plan plan(target, info.area, std::move(gather_plan.second), gather_plan.first);
 
         for (int i = 1, siz = path.size(); i < siz; ++i) plan.plan.emplace_back(path[i-1], from_coord(path[i-1], path[i]));
 
@@ -1049,43 +1135,24 @@ std::optional<Militia_plan> Militia_analyzer::search_plan_from_provider(const Ge
     if (state[provider->position].army - 1 < army_required) return std::nullopt; // 兵力不足
 
     // 此时不需要集合
-    Militia_plan plan(target, nullptr, {}, army_required);
+    Militia_plan plan(target, nullptr, std::pmr::vector<std::pair<Coord, Direction>>(turn_arena.resource()), army_required);
 
     // 从`provider`处走到目标点
-    std::vector<Coord> path = target_dist.path_to_origin(provider->position);
+    std::pmr::vector<Coord> path = target_dist.path_to_origin(provider->position);
     for (int i = 1, siz = path.size(); i < siz; ++i) plan.plan.emplace_back(path[i-1], from_coord(path[i-1], path[i]));
 
     return plan;
 }
 
-void Militia_analyzer::analyzer_dfs(const Coord& coord) noexcept {
-    vis[coord.x][coord.y] = true;
-    areas.back().area++;
-    areas.back()[coord] = true;
-    areas.back().max_army += state[coord].army - 1;
-
-    for (const Coord& dir : DIRECTION_ARR) {
-        Coord next_pos = coord + dir;
-        if (!next_pos.in_map() || vis[next_pos.x][next_pos.y]) continue;
-        if (state[next_pos].player != my_seat) continue;
-
-        const Generals* generals = state[next_pos].generals;
-        if (generals != nullptr && dynamic_cast<const MainGenerals*>(generals)) continue; // 不动主将
-
-        analyzer_dfs(next_pos);
-    }
-}
-
-std::pair<int, std::vector<std::pair<Coord, Direction>>> Militia_analyzer::calc_gather_plan(const Militia_dist_info& info, int required_army, int max_steps) const noexcept {
-    static std::vector<std::pair<Coord, Direction>> plan;
+std::pair<int, std::pmr::vector<std::pair<Coord, Direction>>> Militia_analyzer::calc_gather_plan(const Militia_dist_info& info, int required_army, int max_steps) const noexcept {
+    std::pmr::vector<std::pair<Coord, Direction>> plan(turn_arena.resource());
     const Militia_area& area = *info.area;
     bool step_mode = max_steps >= 0;
 
     // 优先对士兵多的格子进行BFS直至满足要求
     int total_army = 0;
-    plan.clear();
     memset(vis, 0, sizeof(vis));
-    std::priority_queue<__Queue_Node> queue;
+    std::priority_queue<__Queue_Node, std::pmr::vector<__Queue_Node>> queue{std::less<__Queue_Node>(), std::pmr::vector<__Queue_Node>(turn_arena.resource())};
     queue.emplace(info.clostest_point, state[info.clostest_point].army - 1, static_cast<Direction>(-1));
 
     while (!queue.empty() && (!step_mode || (int)plan.size() < max_steps)) {
@@ -1113,5 +1180,5 @@ std::pair<int, std::vector<std::pair<Coord, Direction>>> Militia_analyzer::calc_
     assert(step_mode || total_army >= required_army);
 
     std::reverse(plan.begin(), plan.end());
-    return std::make_pair(total_army, plan);
+    return std::make_pair(total_army, std::move(plan));
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// 二进制编码：字节追加至`data`，无符号整数采用LEB128变长编码，有符号整数先经zigzag变换
+class Byte_writer {
+public:
+    std::string data;
+
+    void u8(uint8_t value) { data.push_back(char(value)); }
+    void varint(uint64_t value) {
+        for (; value >= 0x80; value >>= 7) data.push_back(char(value | 0x80));
+        data.push_back(char(value));
+    }
+    void svarint(int64_t value) { varint((uint64_t(value) << 1) ^ uint64_t(value >> 63)); }
+    void bytes(const void* src, size_t size) { data.append(static_cast<const char*>(src), size); }
+};
+
+// 从不持有的缓冲区中按`Byte_writer`的格式读取，数据不完整时抛出异常
+class Byte_reader {
+public:
+    Byte_reader(const void* data, size_t size) noexcept : ptr(static_cast<const uint8_t*>(data)), end(ptr + size) {}
+
+    uint8_t u8() { require(1); return *ptr++; }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+    int64_t svarint() {
+        uint64_t value = varint();
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+    void bytes(void* dest, size_t size) {
+        require(size);
+        std::memcpy(dest, ptr, size);
+        ptr += size;
+    }
+    void skip(size_t size) { require(size); ptr += size; }
+
+    const uint8_t* position() const noexcept { return ptr; }
+    size_t remaining() const noexcept { return end - ptr; }
+
+private:
+    const uint8_t* ptr;
+    const uint8_t* end;
+
+    void require(size_t size) const {
+        if (size_t(end - ptr) < size) throw std::runtime_error("Unexpected end of data");
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// 命令行参数的逐项读取，供各工具共用：选项形如`--name value`，缺少取值或遇到未知选项时抛出异常
+// 用法：for (Arg_reader args(argc, argv, 1); args.next();) { if (args.is("--seed")) seed = args.uint64_value(); ... else args.unknown(); }
+class Arg_reader {
+public:
+    // 从第`first`个参数开始读取
+    Arg_reader(int argc, char** argv, int first) noexcept : argc(argc), argv(argv), index(first - 1) {}
+
+    // 前进到下一个参数，已读完时返回false
+    bool next() noexcept { return ++index < argc; }
+    // 当前参数
+    const char* current() const noexcept { return argv[index]; }
+    // 当前参数是否为指定选项
+    bool is(const char* name) const noexcept { return !std::strcmp(argv[index], name); }
+    // 当前参数是否为位置参数（不以`-`开头）
+    bool positional() const noexcept { return argv[index][0] != '-'; }
+
+    // 读取当前选项的取值
+    const char* value() {
+        if (index + 1 >= argc) throw std::runtime_error(std::string("Missing value for ") + argv[index]);
+        return argv[++index];
+    }
+    int int_value() { return std::atoi(value()); }
+    uint64_t uint64_value() { return std::strtoull(value(), nullptr, 10); }
+
+    // 当前参数无法识别
+    [[noreturn]] void unknown() const { throw std::runtime_error(std::string("Unknown option: ") + argv[index]); }
+
+private:
+    int argc;
+    char** argv;
+    int index;
+};
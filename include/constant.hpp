@@ -16,12 +16,25 @@
     return std::string(buffer);
 }
 
+// 地图尺寸可在编译时覆盖（如`-DBOARD_COL=32 -DBOARD_ROW=32`），用于评估更大地图下的搜索开销
+#ifndef BOARD_COL
+    #define BOARD_COL 15
+#endif
+#ifndef BOARD_ROW
+    #define BOARD_ROW 15
+#endif
+
 namespace Constant {
     // 玩家数量
     static constexpr int PLAYER_COUNT = 2;
 
-    static constexpr int col = 15; // 定义了地图的列数。
-    static constexpr int row = 15; // 定义了地图的行数。
+    static constexpr int col = BOARD_COL; // 定义了地图的列数。
+    static constexpr int row = BOARD_ROW; // 定义了地图的行数。
+
+    // 将领池容量（含被摧毁的将领），槽位编号需能放入`int16_t`
+    // 槽位不复用，一局所需槽位数为初始将领数加招募次数：招募每次花费`SPAWN_GENERAL_COST`，金币只来自初始金币与油井产出，
+    // 标准地图（14个将领、6口油井、初始金币各40）下500回合至多产出6 * 6 * 500 = 18000，故至多14 + (80 + 18000) / 50 = 375个
+    static constexpr int MAX_GENERALS = 384;
 
     // 油井产量升级相关常数
     static constexpr int OILWELL_PRODUCTION_LEVELS = 4;
@@ -89,6 +102,9 @@ namespace Constant {
     // 超级武器的作用半径（闭区间）
     static constexpr int SUPER_WEAPON_RADIUS = 1;
 
+    // 同时生效的超级武器数量上限（冷却50回合而效果至多持续10回合，实际每方至多1个）
+    static constexpr int MAX_ACTIVE_SUPER_WEAPONS = 8;
+
     // 辐射效果每回合的伤害
     static constexpr int NUCLEAR_BOMB_DAMAGE = 3;
 
@@ -7,6 +7,8 @@
 #include "gamestate.hpp"
 #include "protocol.hpp"
 #include "util.hpp"
+#include "movegen.hpp"
+#include "simulate.hpp"
 #include "logger.hpp"
 
 #include "test_sync.hpp"
@@ -65,7 +67,7 @@ public:
      * @note 此方法断言所有敌方操作合法
      */
     void read_and_apply_enemy_ops() {
-        last_enemy_ops = read_enemy_operations();
+        read_enemy_operations(last_enemy_ops);
         apply_enemy_ops();
     }
 
@@ -108,10 +110,9 @@ void GameController::send_ops() {
     for (const Operation &op : my_operation_list) logger.log(LOG_LEVEL_INFO, "\t%s", op.str().c_str());
 
     // 结束我方操作回合，将操作列表打包发送并清空。
-    std::string msg = "";
-    for (const auto &op : my_operation_list) msg += op.stringize();
-    msg += "8\n";
-    write_to_judger(msg);
+    for (const auto &op : my_operation_list) judger_output.append(op);
+    judger_output.append("8\n");
+    judger_output.send();
 
     my_operation_list.clear();
 }
@@ -5,7 +5,9 @@
 #include <cmath>
 #include <cassert>
 #include <cstring>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
 #include <algorithm>
 #include "constant.hpp"
 
@@ -119,7 +121,7 @@ enum class WeaponType {
 };
 
 // 格子类型
-enum class CellType {
+enum class CellType : int8_t {
     PLAIN = 0,
     DESERT = 1,
     SWAMP = 2,
@@ -167,15 +169,57 @@ struct SuperWeapon {
     int cd; // 冷却回合数
     int rest; // 效果剩余回合数
     Coord position; // 位置坐标
+    SuperWeapon() noexcept = default;
     SuperWeapon(WeaponType type, int player, int cd, int rest, Coord position) noexcept :
         type(type), player(player), cd(cd), rest(rest), position(position) {};
 };
 
+// 将领类型
+enum class GeneralType : int8_t {
+    MAIN_GENERAL = 0,
+    SUB_GENERAL = 1,
+    OIL_WELL = 2,
+    Type_count = 3
+};
+constexpr int GENERAL_TYPE_COUNT = static_cast<int>(GeneralType::Type_count);
+
+// 按[将领类型][当前等级]查询的属性取值与升级开销表，等级超出该类型上限的部分不可达
+// 主将享受`MAIN_GENERAL_DISCOUNT`折扣；油井不能提升移动力，其开销视为无穷大
+constexpr int MAX_GENERAL_TIRES = 4;
+constexpr int PRODUCTION_VALUE_TABLE[GENERAL_TYPE_COUNT][MAX_GENERAL_TIRES] = {
+    {GENERAL_PRODUCTION_VALUES[0], GENERAL_PRODUCTION_VALUES[1], GENERAL_PRODUCTION_VALUES[2], GENERAL_PRODUCTION_VALUES[2]},
+    {GENERAL_PRODUCTION_VALUES[0], GENERAL_PRODUCTION_VALUES[1], GENERAL_PRODUCTION_VALUES[2], GENERAL_PRODUCTION_VALUES[2]},
+    {OILWELL_PRODUCTION_VALUES[0], OILWELL_PRODUCTION_VALUES[1], OILWELL_PRODUCTION_VALUES[2], OILWELL_PRODUCTION_VALUES[3]}
+};
+constexpr double DEFENCE_VALUE_TABLE[GENERAL_TYPE_COUNT][MAX_GENERAL_TIRES] = {
+    {GENERAL_DEFENCE_VALUES[0], GENERAL_DEFENCE_VALUES[1], GENERAL_DEFENCE_VALUES[2], GENERAL_DEFENCE_VALUES[2]},
+    {GENERAL_DEFENCE_VALUES[0], GENERAL_DEFENCE_VALUES[1], GENERAL_DEFENCE_VALUES[2], GENERAL_DEFENCE_VALUES[2]},
+    {OILWELL_DEFENCE_VALUES[0], OILWELL_DEFENCE_VALUES[1], OILWELL_DEFENCE_VALUES[2], OILWELL_DEFENCE_VALUES[3]}
+};
+constexpr int PRODUCTION_COST_TABLE[GENERAL_TYPE_COUNT][MAX_GENERAL_TIRES] = {
+    {GENERAL_PRODUCTION_COST[0] / MAIN_GENERAL_DISCOUNT, GENERAL_PRODUCTION_COST[1] / MAIN_GENERAL_DISCOUNT, GENERAL_PRODUCTION_COST[2] / MAIN_GENERAL_DISCOUNT, 1 << 30},
+    {GENERAL_PRODUCTION_COST[0], GENERAL_PRODUCTION_COST[1], GENERAL_PRODUCTION_COST[2], 1 << 30},
+    {OILWELL_PRODUCTION_COST[0], OILWELL_PRODUCTION_COST[1], OILWELL_PRODUCTION_COST[2], OILWELL_PRODUCTION_COST[3]}
+};
+constexpr int DEFENCE_COST_TABLE[GENERAL_TYPE_COUNT][MAX_GENERAL_TIRES] = {
+    {GENERAL_DEFENCE_COST[0] / MAIN_GENERAL_DISCOUNT, GENERAL_DEFENCE_COST[1] / MAIN_GENERAL_DISCOUNT, GENERAL_DEFENCE_COST[2] / MAIN_GENERAL_DISCOUNT, 1 << 30},
+    {GENERAL_DEFENCE_COST[0], GENERAL_DEFENCE_COST[1], GENERAL_DEFENCE_COST[2], 1 << 30},
+    {OILWELL_DEFENCE_COST[0], OILWELL_DEFENCE_COST[1], OILWELL_DEFENCE_COST[2], OILWELL_DEFENCE_COST[3]}
+};
+constexpr int MOVEMENT_COST_TABLE[GENERAL_TYPE_COUNT][MAX_GENERAL_TIRES] = {
+    {GENERAL_MOVEMENT_COST[0] / MAIN_GENERAL_DISCOUNT, GENERAL_MOVEMENT_COST[1] / MAIN_GENERAL_DISCOUNT, GENERAL_MOVEMENT_COST[2] / MAIN_GENERAL_DISCOUNT, 1 << 30},
+    {GENERAL_MOVEMENT_COST[0], GENERAL_MOVEMENT_COST[1], GENERAL_MOVEMENT_COST[2], 1 << 30},
+    {1 << 30, 1 << 30, 1 << 30, 1 << 30}
+};
+
 class GameState;
 
-// 将军基类
+// 将领类，以`type`区分主将、副将与油井；不含虚函数，可直接按值复制
 class Generals {
 public:
+    GeneralType type; // 将领类型
+    bool alive; // 是否存活，被炸毁的将领保留在将领池中但不再参与遍历
+
     int id; // 将军编号
     int player; //所属玩家
     Coord position; // 位置坐标
@@ -199,37 +243,15 @@ public:
     // 技能是否在生效中
     bool skill_active(SkillType type) const noexcept { return skill_duration[static_cast<int>(type)] > 0; }
 
-    // 获取各项等级
-    virtual int production_tire() const noexcept = 0;
-    virtual int defence_tire() const noexcept = 0;
-    virtual int movement_tire() const noexcept = 0;
-
-    // 获取升级开销
-    virtual int production_upgrade_cost() const noexcept = 0;
-    virtual int defence_upgrade_cost() const noexcept = 0;
-    virtual int movement_upgrade_cost() const noexcept = 0;
-
-    // 提升生产力
-    virtual bool production_up(GameState &gamestate, int player) noexcept = 0;
-    // 提升防御力
-    virtual bool defence_up(GameState &gamestate, int player) noexcept = 0;
-    // 提升移动力
-    virtual bool movement_up(GameState &gamestate, int player) noexcept = 0;
-    Generals(int id, int player, Coord position) noexcept:
-        id(id), player(player), position(position),
-        produce_level(1), defence_level(1), mobility_level(1),
-        skills_cd{0}, skill_duration{0}, rest_move(1) {};
-    ~Generals() = default;
-
-    // 是否有归属
-    bool is_occupied() const noexcept { return player >= 0 && player < PLAYER_COUNT; }
-};
+    // 是否有技能仍在冷却或生效中
+    bool cooling() const noexcept {
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) if (skills_cd[i] > 0 || skill_duration[i] > 0) return true;
+        return false;
+    }
 
-// 油井类，继承自将军基类
-class OilWell final: public Generals {
-public:
-    int production_tire() const noexcept override {
-        switch (produce_level) {
+    // 获取各项等级
+    int production_tire() const noexcept {
+        if (type == GeneralType::OIL_WELL) switch (produce_level) {
             case OILWELL_PRODUCTION_VALUES[0]: return 0;
             case OILWELL_PRODUCTION_VALUES[1]: return 1;
             case OILWELL_PRODUCTION_VALUES[2]: return 2;
@@ -238,9 +260,17 @@ public:
                 assert(!"Invalid oil well production level");
                 return 0;
         }
+        switch (produce_level) {
+            case GENERAL_PRODUCTION_VALUES[0]: return 0;
+            case GENERAL_PRODUCTION_VALUES[1]: return 1;
+            case GENERAL_PRODUCTION_VALUES[2]: return 2;
+            default:
+                assert(!"Invalid general production level");
+                return 0;
+        }
     }
-    int defence_tire() const noexcept override {
-        switch (int(defence_level*2)) {
+    int defence_tire() const noexcept {
+        if (type == GeneralType::OIL_WELL) switch (int(defence_level*2)) {
             case int(OILWELL_DEFENCE_VALUES[0]*2): return 0;
             case int(OILWELL_DEFENCE_VALUES[1]*2): return 1;
             case int(OILWELL_DEFENCE_VALUES[2]*2): return 2;
@@ -249,157 +279,562 @@ public:
                 assert(!"Invalid oil well defence level");
                 return 0;
         }
-    }
-    int movement_tire() const noexcept override {
-        assert(false);
-        return 0;
-    }
-
-
-    int production_upgrade_cost() const noexcept override { return OILWELL_PRODUCTION_COST[production_tire()]; }
-    int defence_upgrade_cost() const noexcept override { return OILWELL_DEFENCE_COST[defence_tire()]; }
-    int movement_upgrade_cost() const noexcept override {
-        assert(false);
-        return 0;
-    }
-
-    bool production_up(GameState &gamestate, int player) noexcept override;
-    bool defence_up(GameState &gamestate, int player) noexcept override;
-    bool movement_up(GameState &gamestate, int player) noexcept override {
-        assert(false);
-        return false;
-    }
-    OilWell(int id, int player, Coord position) noexcept : Generals(id, player, position) {
-        mobility_level = 0;
-    };
-};
-
-// 主将类，继承自将军基类
-class MainGenerals final: public Generals {
-public:
-    int production_tire() const noexcept override {
-        switch (produce_level) {
-            case GENERAL_PRODUCTION_VALUES[0]: return 0;
-            case GENERAL_PRODUCTION_VALUES[1]: return 1;
-            case GENERAL_PRODUCTION_VALUES[2]: return 2;
-            default:
-                assert(!"Invalid main general production level");
-                return 0;
-        }
-    }
-    int defence_tire() const noexcept override {
         switch (int(defence_level)) {
             case GENERAL_DEFENCE_VALUES[0]: return 0;
             case GENERAL_DEFENCE_VALUES[1]: return 1;
             case GENERAL_DEFENCE_VALUES[2]: return 2;
             default:
-                assert(!"Invalid main general defence level");
+                assert(!"Invalid general defence level");
                 return 0;
         }
     }
-    int movement_tire() const noexcept override {
+    int movement_tire() const noexcept {
+        assert(type != GeneralType::OIL_WELL);
         switch (mobility_level) {
             case GENERAL_MOVEMENT_VALUES[0]: return 0;
             case GENERAL_MOVEMENT_VALUES[1]: return 1;
             case GENERAL_MOVEMENT_VALUES[2]: return 2;
             default:
-                assert(!"Invalid main general movement level");
+                assert(!"Invalid general movement level");
                 return 0;
         }
     }
 
-    int production_upgrade_cost() const noexcept override { return GENERAL_PRODUCTION_COST[production_tire()] / MAIN_GENERAL_DISCOUNT; }
-    int defence_upgrade_cost() const noexcept override { return GENERAL_DEFENCE_COST[defence_tire()] / MAIN_GENERAL_DISCOUNT; }
-    int movement_upgrade_cost() const noexcept override { return GENERAL_MOVEMENT_COST[movement_tire()] / MAIN_GENERAL_DISCOUNT; }
+    // 获取升级开销
+    int production_upgrade_cost() const noexcept { return PRODUCTION_COST_TABLE[static_cast<int>(type)][production_tire()]; }
+    int defence_upgrade_cost() const noexcept { return DEFENCE_COST_TABLE[static_cast<int>(type)][defence_tire()]; }
+    int movement_upgrade_cost() const noexcept {
+        assert(type != GeneralType::OIL_WELL);
+        return MOVEMENT_COST_TABLE[static_cast<int>(type)][movement_tire()];
+    }
+
+    // 提升生产力
+    bool production_up(GameState &gamestate, int player) noexcept;
+    // 提升防御力
+    bool defence_up(GameState &gamestate, int player) noexcept;
+    // 提升移动力
+    bool movement_up(GameState &gamestate, int player) noexcept;
+
+    Generals() noexcept = default;
+    Generals(GeneralType type, int id, int player, Coord position) noexcept:
+        type(type), alive(true), id(id), player(player), position(position),
+        produce_level(1), defence_level(1), mobility_level(type == GeneralType::OIL_WELL ? 0 : 1),
+        skills_cd{0}, skill_duration{0}, rest_move(1) {};
 
-    bool production_up(GameState &gamestate, int player) noexcept override;
-    bool defence_up(GameState &gamestate, int player) noexcept override;
-    bool movement_up(GameState &gamestate, int player) noexcept override;
-    MainGenerals(int id, int player, Coord position) noexcept : Generals(id, player, position) {};
+    // 是否有归属
+    bool is_occupied() const noexcept { return player >= 0 && player < PLAYER_COUNT; }
 };
 
-// 副将类，继承自将军基类
-class SubGenerals final: public Generals {
+// 定长内联数组，元素可平凡复制时整体也可平凡复制
+template <typename T, int N>
+class Fixed_vector {
 public:
-    int production_tire() const noexcept override {
-        switch (produce_level) {
-            case GENERAL_PRODUCTION_VALUES[0]: return 0;
-            case GENERAL_PRODUCTION_VALUES[1]: return 1;
-            case GENERAL_PRODUCTION_VALUES[2]: return 2;
-            default:
-                assert(!"Invalid sub general production level");
-                return 0;
-        }
+    Fixed_vector() noexcept : count(0) {}
+
+    int size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    void clear() noexcept { count = 0; }
+
+    void push_back(const T& value) noexcept {
+        assert(count < N);
+        data[count++] = value;
     }
-    int defence_tire() const noexcept override {
-        switch (int(defence_level)) {
-            case GENERAL_DEFENCE_VALUES[0]: return 0;
-            case GENERAL_DEFENCE_VALUES[1]: return 1;
-            case GENERAL_DEFENCE_VALUES[2]: return 2;
-            default:
-                assert(!"Invalid sub general defence level");
-                return 0;
-        }
+    // 原地删除满足`pred`的元素，保持其余元素的相对顺序
+    template <typename Pred>
+    void erase_if(Pred pred) noexcept {
+        count = std::remove_if(data, data + count, pred) - data;
     }
-    int movement_tire() const noexcept override {
-        switch (mobility_level) {
-            case GENERAL_MOVEMENT_VALUES[0]: return 0;
-            case GENERAL_MOVEMENT_VALUES[1]: return 1;
-            case GENERAL_MOVEMENT_VALUES[2]: return 2;
-            default:
-                assert(!"Invalid sub general movement level");
-                return 0;
+
+    friend class GameState;
+
+    T& operator[](int index) noexcept { return data[index]; }
+    const T& operator[](int index) const noexcept { return data[index]; }
+    T* begin() noexcept { return data; }
+    T* end() noexcept { return data + count; }
+    const T* begin() const noexcept { return data; }
+    const T* end() const noexcept { return data + count; }
+
+private:
+    int count;
+    T data[N];
+};
+
+// 将领槽位的集合，以位集表示，按槽位升序遍历
+class Slot_set {
+public:
+    static constexpr int WORDS = (MAX_GENERALS + 63) / 64;
+
+    uint64_t w[WORDS];
+
+    constexpr Slot_set() noexcept : w{} {}
+
+    constexpr bool test(int slot) const noexcept { return (w[slot >> 6] >> (slot & 63)) & 1; }
+    constexpr Slot_set operator&(const Slot_set& other) const noexcept {
+        Slot_set ret;
+        for (int i = 0; i < WORDS; ++i) ret.w[i] = w[i] & other.w[i];
+        return ret;
+    }
+    int count() const noexcept {
+        int ret = 0;
+        for (int i = 0; i < WORDS; ++i) ret += __builtin_popcountll(w[i]);
+        return ret;
+    }
+    // 第一个槽位，为空时返回-1
+    int first() const noexcept {
+        for (int i = 0; i < WORDS; ++i) if (w[i]) return i * 64 + __builtin_ctzll(w[i]);
+        return -1;
+    }
+    // 下一个大于`slot`的槽位，不存在时返回-1
+    int next(int slot) const noexcept {
+        if (++slot >= WORDS * 64) return -1;
+        int i = slot >> 6;
+        uint64_t bits = w[i] & (~0ULL << (slot & 63));
+        while (!bits) {
+            if (++i == WORDS) return -1;
+            bits = w[i];
         }
+        return i * 64 + __builtin_ctzll(bits);
     }
+};
+
+// 将领池：将领按槽位内联存储，槽位在将领被摧毁后保留（`alive`置否）且不再复用
+// 下标访问返回指定槽位（可能已摧毁）的将领，范围for则只遍历存活的将领
+// 另维护按编号、类型与归属的索引（只含存活将领），由`GameState`负责同步
+class General_pool {
+public:
+    General_pool() noexcept : count(0), main_slot{-1, -1} { std::fill_n(id_slot, MAX_GENERALS, -1); }
+
+    // 已使用的槽位数，包括已摧毁的将领
+    int size() const noexcept { return count; }
+    bool full() const noexcept { return count >= MAX_GENERALS; }
+
+    friend class GameState;
 
-    int production_upgrade_cost() const noexcept override { return GENERAL_PRODUCTION_COST[production_tire()]; }
-    int defence_upgrade_cost() const noexcept override { return GENERAL_DEFENCE_COST[defence_tire()]; }
-    int movement_upgrade_cost() const noexcept override { return GENERAL_MOVEMENT_COST[movement_tire()]; }
+    Generals* operator[](int slot) noexcept { assert(slot >= 0 && slot < count); return &pool[slot]; }
+    const Generals* operator[](int slot) const noexcept { assert(slot >= 0 && slot < count); return &pool[slot]; }
+    // 将领所在的槽位
+    int slot_of(const Generals* general) const noexcept { assert(general >= pool && general < pool + count); return general - pool; }
 
-    bool production_up(GameState &gamestate, int player) noexcept override;
-    bool defence_up(GameState &gamestate, int player) noexcept override;
-    bool movement_up(GameState &gamestate, int player) noexcept override;
-    SubGenerals(int id, int player, Coord position) noexcept : Generals(id, player, position) {};
+    // 编号对应的存活将领的槽位，找不到返回-1；编号超出索引范围时逐个查找
+    int find_slot(int id) const noexcept {
+        if (id >= 0 && id < MAX_GENERALS) return id_slot[id];
+        for (int slot = 0; slot < count; ++slot) if (pool[slot].alive && pool[slot].id == id) return slot;
+        return -1;
+    }
+    // 指定玩家的主将槽位（即初始地图中该玩家主将的槽位）
+    int main_general_slot(int player) const noexcept { assert(player >= 0 && player < PLAYER_COUNT); return main_slot[player]; }
+    // 指定类型的存活将领
+    const Slot_set& of_kind(GeneralType type) const noexcept { return kind_slots[static_cast<int>(type)]; }
+    // 归属于指定玩家（-1为无归属）的存活将领
+    const Slot_set& of_player(int player) const noexcept { assert(player >= -1 && player < PLAYER_COUNT); return player_slots[player + 1]; }
+    // 技能仍在冷却或生效中的存活将领，回合结算只需递减其中将领的冷却与持续回合数
+    const Slot_set& cooling() const noexcept { return cooling_slots; }
+
+    // 复制另一将领池：只复制已使用的槽位，其余槽位在`emplace`时才会被写入；`pool`之后的各索引连续存放，整体复制
+    void copy_from(const General_pool& other) noexcept {
+        count = other.count;
+        std::memcpy(static_cast<void*>(pool), other.pool, sizeof(Generals) * count);
+        std::memcpy(static_cast<void*>(id_slot), other.id_slot, reinterpret_cast<const char*>(&other + 1) - reinterpret_cast<const char*>(other.id_slot));
+    }
+
+    // 在新槽位中创建将领，返回槽位编号
+    int emplace(GeneralType type, int id, int player, const Coord& position) noexcept {
+        assert(!full());
+        pool[count] = Generals(type, id, player, position);
+        return count++;
+    }
+
+    // 只遍历存活将领的迭代器
+    template <typename Ptr>
+    class __Iterator {
+    public:
+        __Iterator(Ptr curr, Ptr last) noexcept : curr(curr), last(last) { skip(); }
+        Ptr operator*() const noexcept { return curr; }
+        __Iterator& operator++() noexcept { ++curr; skip(); return *this; }
+        bool operator!=(const __Iterator& other) const noexcept { return curr != other.curr; }
+    private:
+        Ptr curr, last;
+        void skip() noexcept { while (curr != last && !curr->alive) ++curr; }
+    };
+    __Iterator<Generals*> begin() noexcept { return {pool, pool + count}; }
+    __Iterator<Generals*> end() noexcept { return {pool + count, pool + count}; }
+    __Iterator<const Generals*> begin() const noexcept { return {pool, pool + count}; }
+    __Iterator<const Generals*> end() const noexcept { return {pool + count, pool + count}; }
+
+    // 遍历槽位集合中的将领，如`for (const Generals* gen : generals.in(generals.of_kind(type)))`
+    template <typename Ptr>
+    class __Set_range {
+    public:
+        class Iterator {
+        public:
+            Iterator(Ptr pool, const Slot_set* set, int slot) noexcept : pool(pool), set(set), slot(slot) {}
+            Ptr operator*() const noexcept { return pool + slot; }
+            Iterator& operator++() noexcept { slot = set->next(slot); return *this; }
+            bool operator!=(const Iterator& other) const noexcept { return slot != other.slot; }
+        private:
+            Ptr pool;
+            const Slot_set* set;
+            int slot;
+        };
+        __Set_range(Ptr pool, const Slot_set& set) noexcept : pool(pool), set(set) {}
+        Iterator begin() const noexcept { return {pool, &set, set.first()}; }
+        Iterator end() const noexcept { return {pool, &set, -1}; }
+    private:
+        Ptr pool;
+        Slot_set set;
+    };
+    __Set_range<Generals*> in(const Slot_set& set) noexcept { return {pool, set}; }
+    __Set_range<const Generals*> in(const Slot_set& set) const noexcept { return {pool, set}; }
+
+private:
+    int count;
+    Generals pool[MAX_GENERALS];
+
+    // 按编号、类型与归属的索引
+    int16_t id_slot[MAX_GENERALS];
+    int16_t main_slot[PLAYER_COUNT];
+    Slot_set kind_slots[static_cast<int>(GeneralType::Type_count)];
+    Slot_set player_slots[PLAYER_COUNT + 1];
+    Slot_set cooling_slots;
 };
 
 // 格子类
+// 格子：可平凡复制的紧凑结构，整个棋盘可直接按字节复制
 class Cell {
 public:
     // 格子的类型
     CellType type;
 
     // 控制格子的玩家编号
-    int player;
+    int8_t player;
 
-    // 格子的位置坐标
-    Coord position;
+    // 格子上将领在`GameState::generals`中的槽位，无将领时为-1
+    int16_t general_slot;
 
-    // 格子上的将军对象指针，这与`GameState::generals`是连通的
-    Generals* generals;
+    // 覆盖此格的生效中超级武器，第`weapon_bit(type, player)`位表示`player`的`type`类超级武器
+    // 派生自`GameState::active_super_weapon`，由`GameState::add_super_weapon`与回合结算维护
+    uint8_t weapon_status;
 
     // 格子里的军队数量
     int army;
 
-    // 已激活的超级武器列表
-    std::vector<SuperWeapon> weapon_activate;
+    // 格子的位置坐标
+    Coord position;
 
-    Cell() noexcept : type(CellType::PLAIN), player(-1), generals(nullptr), army(0) {};
+    Cell() noexcept : type(CellType::PLAIN), player(-1), general_slot(-1), weapon_status(0), army(0) {};
 
     // 格子上是否有将领
-    bool has_general() const noexcept { return generals != nullptr; }
+    bool has_general() const noexcept { return general_slot >= 0; }
 
     // 格子是否有归属
     bool is_occupied() const noexcept { return player >= 0 && player < PLAYER_COUNT; }
 
+    // `weapon_status`中表示`player`的`type`类超级武器的位
+    static constexpr uint8_t weapon_bit(WeaponType type, int player) noexcept { return 1 << (static_cast<int>(type) * PLAYER_COUNT + player); }
+    // 此格是否处于`player`的`type`类超级武器作用下
+    bool weapon_active(WeaponType type, int player) const noexcept { return weapon_status & weapon_bit(type, player); }
+    // 此格是否处于任一玩家的`type`类超级武器作用下
+    bool weapon_active(WeaponType type) const noexcept {
+        uint8_t mask = 0;
+        for (int p = 0; p < PLAYER_COUNT; ++p) mask |= weapon_bit(type, p);
+        return weapon_status & mask;
+    }
+};
+static_assert(std::is_trivially_copyable_v<Cell> && sizeof(Cell) <= 20, "Cell must stay a compact trivially copyable struct");
+static_assert(4 * PLAYER_COUNT <= 8, "Cell::weapon_status too narrow");
+
+// 位棋盘：每格占一位，位下标为`x * STRIDE + y`，行宽填充至2的幂且至少留出一列恒为0，因而左右平移不会跨行串位
+// 15*15的地图填充为15*16=240位，恰好装入4个64位字，集合运算、膨胀与洪泛填充均为少量字运算
+class Bitboard {
+public:
+    static constexpr int STRIDE = [] { int ret = 1; while (ret <= Constant::row) ret <<= 1; return ret; }();
+    static constexpr int WORDS = (Constant::col * STRIDE + 63) / 64;
+
+    uint64_t w[WORDS];
+
+    constexpr Bitboard() noexcept : w{} {}
+
+    // 坐标与位下标的互相转换
+    static constexpr int bit(const Coord& pos) noexcept { return pos.x * STRIDE + pos.y; }
+    static constexpr Coord coord(int bit) noexcept { return Coord(bit / STRIDE, bit % STRIDE); }
+
+    // 地图内全部格子
+    static const Bitboard FULL;
+    // 仅含一格
+    static constexpr Bitboard single(const Coord& pos) noexcept { Bitboard ret; ret.set(pos); return ret; }
+    // 以`center`为中心、切比雪夫半径为`radius`的正方形区域（截断至地图内）
+    static constexpr Bitboard square(const Coord& center, int radius) noexcept {
+        Bitboard ret;
+        int y_min = std::max(center.y - radius, 0), y_max = std::min(center.y + radius, Constant::row - 1);
+        for (int x = std::max(center.x - radius, 0); x <= std::min(center.x + radius, Constant::col - 1); ++x)
+            ret.set_range(x * STRIDE + y_min, x * STRIDE + y_max);
+        return ret;
+    }
+
+    // 单格读写
+    constexpr bool test(int bit) const noexcept { return (w[bit >> 6] >> (bit & 63)) & 1; }
+    constexpr bool test(const Coord& pos) const noexcept { return test(bit(pos)); }
+    constexpr void set(const Coord& pos) noexcept { w[bit(pos) >> 6] |= 1ULL << (bit(pos) & 63); }
+    constexpr void reset(const Coord& pos) noexcept { w[bit(pos) >> 6] &= ~(1ULL << (bit(pos) & 63)); }
+
+    // 集合运算，取补时截断至地图内
+    constexpr Bitboard operator&(const Bitboard& o) const noexcept { Bitboard ret; for (int i = 0; i < WORDS; ++i) ret.w[i] = w[i] & o.w[i]; return ret; }
+    constexpr Bitboard operator|(const Bitboard& o) const noexcept { Bitboard ret; for (int i = 0; i < WORDS; ++i) ret.w[i] = w[i] | o.w[i]; return ret; }
+    constexpr Bitboard operator^(const Bitboard& o) const noexcept { Bitboard ret; for (int i = 0; i < WORDS; ++i) ret.w[i] = w[i] ^ o.w[i]; return ret; }
+    constexpr Bitboard operator~() const noexcept { Bitboard ret; for (int i = 0; i < WORDS; ++i) ret.w[i] = ~w[i] & FULL.w[i]; return ret; }
+    constexpr Bitboard& operator&=(const Bitboard& o) noexcept { return *this = *this & o; }
+    constexpr Bitboard& operator|=(const Bitboard& o) noexcept { return *this = *this | o; }
+    constexpr bool operator==(const Bitboard& o) const noexcept {
+        for (int i = 0; i < WORDS; ++i) if (w[i] != o.w[i]) return false;
+        return true;
+    }
+    constexpr bool operator!=(const Bitboard& o) const noexcept { return !(*this == o); }
+
+    constexpr bool any() const noexcept {
+        for (int i = 0; i < WORDS; ++i) if (w[i]) return true;
+        return false;
+    }
+    int count() const noexcept {
+        int ret = 0;
+        for (int i = 0; i < WORDS; ++i) ret += __builtin_popcountll(w[i]);
+        return ret;
+    }
+    // 最低位的下标，须非空
+    int lowest() const noexcept {
+        for (int i = 0; i < WORDS; ++i) if (w[i]) return i * 64 + __builtin_ctzll(w[i]);
+        assert(!"Empty bitboard");
+        return -1;
+    }
+
+    // 整体向高位/低位平移`n`位（`n >= 0`），不截断
+    constexpr Bitboard shl(int n) const noexcept {
+        Bitboard ret;
+        int words = n >> 6, bits = n & 63;
+        for (int i = WORDS - 1; i >= words; --i) {
+            ret.w[i] = w[i - words] << bits;
+            if (bits && i - words - 1 >= 0) ret.w[i] |= w[i - words - 1] >> (64 - bits);
+        }
+        return ret;
+    }
+    constexpr Bitboard shr(int n) const noexcept {
+        Bitboard ret;
+        int words = n >> 6, bits = n & 63;
+        for (int i = 0; i + words < WORDS; ++i) {
+            ret.w[i] = w[i + words] >> bits;
+            if (bits && i + words + 1 < WORDS) ret.w[i] |= w[i + words + 1] << (64 - bits);
+        }
+        return ret;
+    }
+    // 四连通膨胀一步（含自身）
+    constexpr Bitboard dilate() const noexcept { return (*this | shl(1) | shr(1) | shl(STRIDE) | shr(STRIDE)) & FULL; }
+    // 以此为种子，在`passable`内四连通洪泛填充（结果含种子本身）
+    constexpr Bitboard flood_fill(const Bitboard& passable) const noexcept {
+        Bitboard curr = *this, next = (curr.dilate() & passable) | curr;
+        while (next != curr) {
+            curr = next;
+            next = (curr.dilate() & passable) | curr;
+        }
+        return curr;
+    }
+
+    // 按位下标升序（即先x后y）遍历所有格子，`func`接受位下标
+    template <typename Func>
+    void for_each(Func func) const noexcept {
+        for (int i = 0; i < WORDS; ++i) for (uint64_t bits = w[i]; bits; bits &= bits - 1) func(i * 64 + __builtin_ctzll(bits));
+    }
+
+private:
+    // 置位闭区间`[lo, hi]`
+    constexpr void set_range(int lo, int hi) noexcept {
+        for (int i = lo >> 6; i <= hi >> 6; ++i) {
+            int from = std::max(lo, i * 64) & 63, to = std::min(hi, i * 64 + 63) & 63;
+            w[i] |= (~0ULL >> (63 - to)) & (~0ULL << from);
+        }
+    }
+    static constexpr Bitboard __full() noexcept {
+        Bitboard ret;
+        for (int x = 0; x < Constant::col; ++x) ret.set_range(x * STRIDE, x * STRIDE + Constant::row - 1);
+        return ret;
+    }
+};
+inline constexpr Bitboard Bitboard::FULL = Bitboard::__full();
+
+// 棋盘的SoA存储：格子的各项属性分别存放于稠密数组中，供全盘扫描与邻格遍历使用
+// 下标为`(x + 1) * STRIDE + y`：行宽同`Bitboard`，填充列与首末两行为哨兵，因此邻格下标无需越界检查
+// 数据由`GameState`的格子修改函数与`Cell`同步维护
+struct Board_planes {
+    static constexpr int STRIDE = Bitboard::STRIDE;
+    static constexpr int SIZE = STRIDE * (Constant::col + 2);
+    static_assert(Constant::row < STRIDE, "Board too wide for the padded stride");
+
+    // 哨兵格的取值
+    static constexpr int8_t OUTSIDE_PLAYER = -2;
+    static constexpr int8_t OUTSIDE_TERRAIN = -1;
+
+    // 四个方向上相邻格的下标偏移，与`DIRECTION_ARR`一一对应
+    static constexpr int DIRECTION_OFFSET[DIRECTION_COUNT] = {-STRIDE, STRIDE, -1, 1};
+
+    int8_t player[SIZE]; // 格子归属，哨兵为`OUTSIDE_PLAYER`
+    int army[SIZE]; // 兵力，哨兵为0
+    int8_t terrain[SIZE]; // `CellType`，哨兵为`OUTSIDE_TERRAIN`
+    int16_t general_slot[SIZE]; // 将领槽位，无将领或哨兵为-1
+
+    // 位棋盘视图
+    Bitboard owned[PLAYER_COUNT]; // 各玩家占领的格子
+    Bitboard swamp; // 沼泽
+    Bitboard desert; // 流沙
+    Bitboard occupied; // 有将领的格子
+    Bitboard multi_army; // 兵力大于1的格子
+
+    // 坐标与下标的互相转换
+    static constexpr int index(const Coord& pos) noexcept { return (pos.x + 1) * STRIDE + pos.y; }
+    static constexpr int index(int x, int y) noexcept { return (x + 1) * STRIDE + y; }
+    static constexpr Coord coord(int idx) noexcept { return Coord(idx / STRIDE - 1, idx % STRIDE); }
+    // 下标是否对应地图内的格子
+    static constexpr bool inside(int idx) noexcept {
+        return idx >= STRIDE && idx < SIZE - STRIDE && idx % STRIDE < Constant::row;
+    }
+
+    // 地图内格子下标的范围为`[FIRST, LAST)`，遍历时需跳过`inside`为假的填充列
+    static constexpr int FIRST = STRIDE;
+    static constexpr int LAST = SIZE - STRIDE;
+};
+
+// 攻防倍率场：各格对各玩家的攻击/防御倍率，由技能光环与强化超级武器的计数得出
+// 仅在光环或强化范围变化时更新受影响的格子，查询时只需读取一次
+// 防御倍率不含格上将领自身的防御等级
+struct Multiplier_field {
+    // 第一维下标为玩家编号+1，0号对应无归属
+    static constexpr int SLOTS = PLAYER_COUNT + 1;
+
+    double attack[SLOTS][Constant::col][Constant::row];
+    double defence[SLOTS][Constant::col][Constant::row];
+
+    // 影响各格的统率、防御、弱化光环数与强化超级武器数
+    int8_t command_count[SLOTS][Constant::col][Constant::row];
+    int8_t defence_count[SLOTS][Constant::col][Constant::row];
+    int8_t weaken_count[SLOTS][Constant::col][Constant::row];
+    int8_t enhance_count[SLOTS][Constant::col][Constant::row];
+
+    // 各格上将领当前施加的光环编码：低2位为格子归属+1，其余位依次为统率、防御、弱化；无光环为0
+    uint8_t aura[Constant::col][Constant::row];
+
+    static constexpr uint8_t AURA_COMMAND = 1 << 2;
+    static constexpr uint8_t AURA_DEFENCE = 1 << 3;
+    static constexpr uint8_t AURA_WEAKEN = 1 << 4;
+
+    // 光环`aura`为阵营`slot`计入的统率、防御、弱化数：统率与防御只对同阵营生效，弱化只对其他阵营生效
+    static void aura_effect(uint8_t aura, int slot, int& command, int& defence, int& weaken) noexcept {
+        bool own = (aura & 3) == slot;
+        command = own && (aura & AURA_COMMAND);
+        defence = own && (aura & AURA_DEFENCE);
+        weaken = !own && (aura & AURA_WEAKEN);
+    }
+    // 由某格某阵营的各项计数求攻防倍率
+    // 各倍率均为2的幂与3的幂之积，浮点乘法无舍入，因而结果与逐个相乘的顺序无关
+    static void combine(int command, int defence, int weaken, int enhance, double& attack_out, double& defence_out) noexcept {
+        double attack = 1.0, defend = 1.0;
+        for (int i = 0; i < command; ++i) attack *= GENERAL_SKILL_EFFECT[SkillType::COMMAND];
+        for (int i = 0; i < defence; ++i) defend *= GENERAL_SKILL_EFFECT[SkillType::DEFENCE];
+        for (int i = 0; i < weaken; ++i) {
+            attack *= GENERAL_SKILL_EFFECT[SkillType::WEAKEN];
+            defend *= GENERAL_SKILL_EFFECT[SkillType::WEAKEN];
+        }
+        // 多个强化超级武器的效果不叠加
+        if (enhance > 0) {
+            attack *= ATTACK_ENHANCE_EFFECT;
+            defend *= ATTACK_ENHANCE_EFFECT;
+        }
+        attack_out = attack;
+        defence_out = defend;
+    }
 };
 
+// 单个玩家的汇总量，由`GameState`的格子与将领修改函数增量维护
+struct Player_stats {
+    int oil_production; // 所属油井的总产量
+    int oil_wells; // 所属油井数
+    int total_army; // 所属格子的兵力和
+    int cells_owned; // 所属格子数
+};
+
+// 撤销日志：按操作分段记录被修改字段的原值，回滚时间正比于修改次数
+// 日志中保存的是字段地址，因此只能用于记录它的那个`GameState`对象
+class Undo_journal {
+public:
+    // 已记录的操作数
+    int op_count() const noexcept { return op_begin.size(); }
+    // 已记录的字段修改数
+    int record_count() const noexcept { return records.size(); }
+
+    // 开始记录一个新的操作
+    void begin_op() noexcept { op_begin.push_back(records.size()); }
+    // 记录字段被修改前的值
+    template <typename T>
+    void save(T& field) noexcept {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t), "Field not recordable");
+        uint64_t old_value = 0;
+        std::memcpy(&old_value, &field, sizeof(T));
+        __record(&field, old_value, sizeof(T));
+    }
+    // 记录一段内存被修改前的内容，按8字节分块
+    void save_bytes(void* addr, int size) noexcept {
+        char* bytes = static_cast<char*>(addr);
+        for (int i = 0; i < size; i += sizeof(uint64_t)) {
+            Record& record = records.emplace_back();
+            record.addr = bytes + i;
+            record.size = std::min<int>(sizeof(uint64_t), size - i);
+            std::memcpy(&record.old_value, bytes + i, record.size);
+        }
+    }
+    // 撤销最近的`n`个操作
+    void undo(int n) noexcept {
+        assert(n >= 0 && n <= op_count());
+        if (n == 0) return;
+        int target = op_begin[op_begin.size() - n];
+        for (int i = int(records.size()) - 1; i >= target; --i) std::memcpy(records[i].addr, &records[i].old_value, records[i].size);
+        records.resize(target);
+        op_begin.resize(op_begin.size() - n);
+    }
+    // 清空日志（不回滚）
+    void clear() noexcept {
+        records.clear();
+        op_begin.clear();
+    }
+
+    friend class State_snapshot;
+
+private:
+    struct Record {
+        void* addr;
+        uint64_t old_value;
+        int size;
+    };
+    // 追加记录的实际实现。不内联，使`GameState::assign`等修改函数在未挂接日志时保持短小、可被内联
+    [[gnu::noinline, gnu::cold]] void __record(void* addr, uint64_t old_value, int size) noexcept {
+        Record& record = records.emplace_back();
+        record.addr = addr;
+        record.size = size;
+        record.old_value = old_value;
+    }
+    std::vector<Record> records;
+    std::vector<int> op_begin; // 各操作在`records`中的起始下标
+};
+
+// Zobrist哈希使用的64位混合函数（splitmix64的输出变换），为双射
+constexpr uint64_t zobrist_mix(uint64_t x) noexcept {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
 // 游戏状态类
 class GameState {
 public:
     int round; // 当前游戏回合数
-    std::vector<Generals*> generals;
+    General_pool generals; // 将领池，格子通过槽位编号引用其中的将领
     int coin[PLAYER_COUNT]; // 每个玩家的金币数量列表，分别对应玩家1，玩家2
-    std::vector<SuperWeapon> active_super_weapon;
+    Fixed_vector<SuperWeapon, MAX_ACTIVE_SUPER_WEAPONS> active_super_weapon;
     bool super_weapon_unlocked[PLAYER_COUNT]; // 超级武器是否解锁的列表，解锁了是true，分别对应玩家1，玩家2
     int super_weapon_cd[PLAYER_COUNT]; // 超级武器的冷却回合数列表，分别对应玩家1，玩家2
     int tech_level[PLAYER_COUNT][4]; // 科技等级列表，第一层对应玩家一，玩家二，第二层分别对应行动力，免疫沼泽，免疫流沙，超级武器
@@ -409,18 +844,137 @@ public:
 
     // 游戏棋盘的二维列表，每个元素是一个Cell对象，下标为[x][y]
     Cell board[Constant::col][Constant::row];
+    // 与`board`同步的SoA棋盘，只读；修改格子须经由`set_cell_*`函数
+    Board_planes planes;
+    // 增量维护的攻防倍率场，只读；通过`attack_multiplier`与`defence_multiplier`查询
+    Multiplier_field multipliers;
+    // 增量维护的各玩家汇总量，只读；通过`calc_oil_production`、`total_army`等函数查询
+    Player_stats stats[PLAYER_COUNT];
+
+    // 当前挂接的撤销日志，为nullptr时不记录
+    Undo_journal* journal;
+
+    // 增量维护的Zobrist哈希值，覆盖格子地形/归属/兵力/将领、将领位置与各项属性、技能冷却、科技、金币与生效中的超级武器
+    // 不含回合数，故相邻回合的相同局面哈希值相同
+    uint64_t zobrist;
 
     GameState() noexcept :
         round(1), coin{0, 0},
         super_weapon_unlocked{false, false}, super_weapon_cd{-1, -1},
         tech_level{{2, 0, 0, 0}, {2, 0, 0, 0}}, rest_move_step{2, 2},
-        next_generals_id(0), board{} {}
-    ~GameState() {
-        for (Generals* gen : generals) delete gen;
+        next_generals_id(0), board{}, journal(nullptr), zobrist(0) {
+        for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) board[x][y].position = Coord(x, y);
+        rebuild_derived();
     }
-    // 复制函数，注意复制将会重新生成将领对象以断开拷贝前后对象间的联系
+    // 复制函数：状态不含任何外部指针，整体复制即可（撤销日志不随之复制）
     GameState& copy_as(const GameState& other) noexcept;
 
+    // 挂接/解除撤销日志，挂接期间`execute_operation`对状态的修改均可撤销
+    void attach_journal(Undo_journal* new_journal) noexcept { journal = new_journal; }
+    void detach_journal() noexcept { journal = nullptr; }
+    // 撤销最近的`n`个（成功执行的）操作
+    void undo(int n) noexcept {
+        assert(journal != nullptr);
+        journal->undo(n);
+    }
+
+    // 修改状态的统一入口：对状态的所有修改都应经由以下函数进行，以便记录撤销日志并维护哈希值
+    template <typename T>
+    void assign(T& field, std::common_type_t<T> value) noexcept {
+        if (field == value) return;
+        if (journal) journal->save(field);
+        zobrist ^= field_key(field);
+        field = value;
+        zobrist ^= field_key(field);
+    }
+    // 在将领池中创建将领，返回槽位编号
+    int add_general(GeneralType type, int id, int player, const Coord& pos) noexcept {
+        if (journal) {
+            journal->save(generals.count);
+            journal->save_bytes(&generals.pool[generals.count], sizeof(Generals));
+        }
+        int slot = generals.emplace(type, id, player, pos);
+        zobrist ^= general_key(*generals[slot]);
+        index_general(slot, true);
+        count_oil_well(*generals[slot], 1);
+        return slot;
+    }
+    // 修改将领的归属
+    void set_general_player(Generals& general, int player) noexcept {
+        int slot = generals.slot_of(&general);
+        count_oil_well(general, -1);
+        assign_slot(generals.player_slots[general.player + 1], slot, false);
+        assign(general.player, player);
+        assign_slot(generals.player_slots[player + 1], slot, true);
+        count_oil_well(general, 1);
+    }
+    // 修改将领的生产力
+    void set_produce_level(Generals& general, int value) noexcept {
+        count_oil_well(general, -1);
+        assign(general.produce_level, value);
+        count_oil_well(general, 1);
+    }
+    // 摧毁将领，其槽位保留
+    void destroy_general(Generals& general) noexcept {
+        count_oil_well(general, -1);
+        index_general(generals.slot_of(&general), false);
+        assign(general.alive, false);
+    }
+    // 添加生效中的超级武器
+    void add_super_weapon(const SuperWeapon& weapon) noexcept {
+        if (journal) {
+            journal->save(active_super_weapon.count);
+            journal->save_bytes(&active_super_weapon.data[active_super_weapon.count], sizeof(SuperWeapon));
+        }
+        active_super_weapon.push_back(weapon);
+        zobrist ^= weapon_key(weapon);
+        if (weapon.type == WeaponType::ATTACK_ENHANCE) apply_enhance(weapon, 1);
+        apply_weapon_status(weapon, true);
+    }
+    // 修改将领的技能冷却回合数，同时维护`General_pool::cooling`
+    void set_skill_cd(Generals& general, SkillType type, int value) noexcept {
+        assign(general.skills_cd[static_cast<int>(type)], value);
+        if (value > 0) assign_slot(generals.cooling_slots, generals.slot_of(&general), true);
+    }
+    // 修改将领的技能持续回合数，同时维护倍率场与`General_pool::cooling`
+    void set_skill_duration(Generals& general, SkillType type, int value) noexcept {
+        assign(general.skill_duration[static_cast<int>(type)], value);
+        if (value > 0) assign_slot(generals.cooling_slots, generals.slot_of(&general), true);
+        refresh_aura(general.position);
+    }
+
+    // 修改格子的兵力、归属与将领，同时维护`planes`
+    void set_cell_army(Cell& cell, int army) noexcept {
+        int old_army = cell.army;
+        if (cell.is_occupied()) assign_derived(stats[cell.player].total_army, stats[cell.player].total_army + army - old_army);
+        assign(cell.army, army);
+        assign_derived(planes.army[Board_planes::index(cell.position)], army);
+        assign_bit(planes.multi_army, cell.position, army > 1);
+    }
+    void set_cell_player(Cell& cell, int player) noexcept {
+        int old_player = cell.player;
+        for (int p = 0; p < PLAYER_COUNT; ++p) if (p == old_player || p == player) assign_bit(planes.owned[p], cell.position, p == player);
+        assign(cell.player, player);
+        assign_derived(planes.player[Board_planes::index(cell.position)], int8_t(player));
+        refresh_aura(cell.position);
+        if (old_player != player) for (int p = 0; p < PLAYER_COUNT; ++p) if (p == old_player || p == player) {
+            int sign = p == player ? 1 : -1;
+            assign_derived(stats[p].cells_owned, stats[p].cells_owned + sign);
+            assign_derived(stats[p].total_army, stats[p].total_army + sign * cell.army);
+        }
+    }
+    void set_cell_general(Cell& cell, int slot) noexcept {
+        assign(cell.general_slot, slot);
+        assign_derived(planes.general_slot[Board_planes::index(cell.position)], int16_t(slot));
+        assign_bit(planes.occupied, cell.position, slot >= 0);
+        refresh_aura(cell.position);
+    }
+
+    // 从头计算哈希值，用于直接改写状态（如读入地图）后的初始化与校验
+    uint64_t calc_zobrist() const noexcept;
+    // 直接改写状态（如读入地图）后，重建哈希值与`planes`等派生数据
+    void rebuild_derived() noexcept;
+
     // 便捷的取Cell方法
     Cell& operator[](const Coord& pos) noexcept {
         assert(pos.in_map());
@@ -430,11 +984,48 @@ public:
         assert(pos.in_map());
         return board[pos.x][pos.y];
     }
+    // 取某格上的将领，无将领时返回nullptr
+    Generals* general_at(const Coord& pos) noexcept {
+        int slot = (*this)[pos].general_slot;
+        return slot >= 0 ? generals[slot] : nullptr;
+    }
+    const Generals* general_at(const Coord& pos) const noexcept {
+        int slot = (*this)[pos].general_slot;
+        return slot >= 0 ? generals[slot] : nullptr;
+    }
 
     // 计算某玩家的军队【从`pos`出发时】获得的攻击力加成，玩家默认为拥有此格的玩家
-    double attack_multiplier(const Coord& pos, int player = std::numeric_limits<int>::min()) const noexcept;
+    double attack_multiplier(const Coord& pos, int player = std::numeric_limits<int>::min()) const noexcept {
+        assert(pos.in_map());
+        if (player == std::numeric_limits<int>::min()) player = board[pos.x][pos.y].player;
+        assert(player >= -1 && player < PLAYER_COUNT);
+        return multipliers.attack[player + 1][pos.x][pos.y];
+    }
     // 计算某玩家防御某格时获得的防御力加成，玩家默认为拥有此格的玩家
-    double defence_multiplier(const Coord& pos, int player = std::numeric_limits<int>::min()) const noexcept;
+    double defence_multiplier(const Coord& pos, int player = std::numeric_limits<int>::min()) const noexcept {
+        assert(pos.in_map());
+        const Cell& cell = board[pos.x][pos.y];
+        if (player == std::numeric_limits<int>::min()) player = cell.player;
+        assert(player >= -1 && player < PLAYER_COUNT);
+        double defence = multipliers.defence[player + 1][pos.x][pos.y];
+        // 考虑cell上是否有general，它的防御力是否被升级
+        if (cell.has_general()) defence *= generals[cell.general_slot]->defence_level;
+        return defence;
+    }
+    // 假设`from`处的将领已移至`to`（各格归属不变），`player`的军队从`pos`出发时的攻击倍率
+    double attack_multiplier_after_move(const Coord& from, const Coord& to, const Coord& pos, int player) const noexcept {
+        double attack, defence;
+        multipliers_after_move(from, to, pos, player, attack, defence);
+        return attack;
+    }
+    // 假设`from`处的将领已移至`to`（各格归属不变），`pos`的归属者防御此格时的防御倍率
+    double defence_multiplier_after_move(const Coord& from, const Coord& to, const Coord& pos) const noexcept {
+        double attack, defence;
+        multipliers_after_move(from, to, pos, board[pos.x][pos.y].player, attack, defence);
+        int slot = pos == to ? board[from.x][from.y].general_slot : pos == from ? -1 : board[pos.x][pos.y].general_slot;
+        if (slot >= 0) defence *= generals[slot]->defence_level;
+        return defence;
+    }
     // 返回某格上某玩家的有效士兵数，负数表示敌军
     int eff_army(const Coord& pos, int player) const noexcept {
         assert(pos.in_map());
@@ -473,24 +1064,32 @@ public:
     bool has_swamp_tech(int player) const noexcept { return tech_level[player][static_cast<int>(TechType::IMMUNE_SWAMP)] > 0; }
     // 获取指定玩家是否能免疫流沙
     bool has_desert_tech(int player) const noexcept { return tech_level[player][static_cast<int>(TechType::IMMUNE_SAND)] > 0; }
-    // 计算指定玩家每回合的石油产量
-    int calc_oil_production(int player) const noexcept;
-    // 计算指定玩家的油井数量
-    int count_oil_wells(int player) const noexcept {
-        return std::count_if(generals.begin(), generals.end(),
-                             [player](const Generals* gen) { return dynamic_cast<const OilWell*>(gen) && gen->player == player; });
-    }
+    // 指定玩家每回合的石油产量
+    int calc_oil_production(int player) const noexcept { return stats[player].oil_production; }
+    // 指定玩家的油井数量
+    int count_oil_wells(int player) const noexcept { return stats[player].oil_wells; }
+    // 指定玩家所有格子的兵力和
+    int total_army(int player) const noexcept { return stats[player].total_army; }
+    // 指定玩家占领的格子数
+    int cells_owned(int player) const noexcept { return stats[player].cells_owned; }
 
     // 寻找将军id对应的格子，找不到返回`(-1,-1)`
     Coord find_general_position_by_id(int general_id) const noexcept {
-        for (const Generals* gen : generals) if (gen->id == general_id) return gen->position;
-        return Coord(-1, -1);
+        int slot = generals.find_slot(general_id);
+        return slot >= 0 ? generals[slot]->position : Coord(-1, -1);
     }
-    Generals* find_general_by_id(int general_id) const noexcept {
-        for (Generals* gen : generals) if (gen->id == general_id) return gen;
-        assert(!"General not found");
-        return nullptr;
+    Generals* find_general_by_id(int general_id) noexcept {
+        int slot = generals.find_slot(general_id);
+        assert(slot >= 0 && "General not found");
+        return slot >= 0 ? generals[slot] : nullptr;
     }
+    const Generals* find_general_by_id(int general_id) const noexcept {
+        int slot = generals.find_slot(general_id);
+        assert(slot >= 0 && "General not found");
+        return slot >= 0 ? generals[slot] : nullptr;
+    }
+    // 指定玩家的主将
+    const Generals* main_general(int player) const noexcept { return generals[generals.main_general_slot(player)]; }
     // 考虑沼泽科技，指定玩家的【军队】是否可以移动到指定位置
     bool can_soldier_step_on(const Coord& pos, int player) const noexcept {
         assert(pos.in_map());
@@ -501,157 +1100,369 @@ public:
     bool can_general_step_on(const Coord& pos, int player) const noexcept {
         assert(pos.in_map());
         const Cell& cell = board[pos.x][pos.y];
-        if (cell.generals != nullptr) return false;
+        if (cell.has_general()) return false;
         return cell.type != CellType::SWAMP || tech_level[player][static_cast<int>(TechType::IMMUNE_SWAMP)] > 0;
     }
 
     // 更新游戏回合信息
     void update_round() noexcept;
+
+private:
+    // 修改派生数据：只记录撤销日志，不参与哈希
+    template <typename T>
+    void assign_derived(T& field, std::common_type_t<T> value) noexcept {
+        if (journal) journal->save(field);
+        field = value;
+    }
+    // 将领施加的光环编码（见`Multiplier_field::aura`），`owner`为其所在格的归属
+    static uint8_t aura_of(const Generals& general, int owner) noexcept;
+    // 重新计算`pos`处将领施加的光环，若有变化则更新其影响范围内的倍率场
+    void refresh_aura(const Coord& pos) noexcept;
+    // 将光环`aura`以`sign`（1或-1）的方式计入`center`周围的倍率场
+    void apply_aura(const Coord& center, uint8_t aura, int sign) noexcept;
+    // 将强化超级武器以`sign`（1或-1）的方式计入倍率场
+    void apply_enhance(const SuperWeapon& weapon, int sign) noexcept;
+    // 根据计数重新计算某格的倍率
+    void update_multiplier(int x, int y) noexcept;
+    // `attack_multiplier_after_move`与`defence_multiplier_after_move`的公共部分：按移动后的光环调整计数后求倍率，不含将领防御等级
+    void multipliers_after_move(const Coord& from, const Coord& to, const Coord& pos, int player, double& attack, double& defence) const noexcept;
+    // 在超级武器作用范围内的格子上置位或清除其`Cell::weapon_status`位，传送只作用于落点
+    void apply_weapon_status(const SuperWeapon& weapon, bool value) noexcept;
+
+    // 将槽位`slot`的将领加入或移出将领池的各项索引
+    void index_general(int slot, bool value) noexcept;
+    // 若`general`是有归属的存活油井，将其以`sign`（1或-1）的方式计入所属玩家的油井统计
+    void count_oil_well(const Generals& general, int sign) noexcept {
+        if (general.type != GeneralType::OIL_WELL || !general.alive || !general.is_occupied()) return;
+        Player_stats& stat = stats[general.player];
+        assign_derived(stat.oil_wells, stat.oil_wells + sign);
+        assign_derived(stat.oil_production, stat.oil_production + sign * general.produce_level);
+    }
+    // 修改槽位集合中的一位，实际只记录其所在的字
+    void assign_slot(Slot_set& set, int slot, bool value) noexcept {
+        uint64_t& word = set.w[slot >> 6];
+        uint64_t mask = 1ULL << (slot & 63);
+        if (bool(word & mask) != value) assign_derived(word, word ^ mask);
+    }
+    // 修改位棋盘中的一位，实际只记录其所在的字
+    void assign_bit(Bitboard& bits, const Coord& pos, bool value) noexcept {
+        int bit = Bitboard::bit(pos);
+        uint64_t& word = bits.w[bit >> 6];
+        uint64_t mask = 1ULL << (bit & 63);
+        if (bool(word & mask) != value) assign_derived(word, word ^ mask);
+    }
+
+    // 字段以其在对象中的字节偏移标识，键值由偏移与字段取值混合得到
+    // 相当于为每个(字段, 取值)对预先生成随机数的Zobrist表，但兵力等无界取值也无需建表
+    // 取值乘以奇数常数再加偏移后只混合一次：同一字段的不同取值、同一取值的不同字段得到的混合输入均不同
+    template <typename T>
+    uint64_t field_key(const T& field) const noexcept {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t), "Field not hashable");
+        uint64_t offset = reinterpret_cast<const char*>(&field) - reinterpret_cast<const char*>(this);
+        assert(offset < sizeof(GameState));
+        uint64_t value = 0;
+        std::memcpy(&value, &field, sizeof(T));
+        return zobrist_mix(value * 0x9e3779b97f4a7c15ULL + offset);
+    }
+    // 单个将领（槽位）的键值
+    uint64_t general_key(const Generals& general) const noexcept {
+        uint64_t ret = field_key(general.type) ^ field_key(general.alive) ^ field_key(general.id) ^ field_key(general.player) ^
+                       field_key(general.position) ^ field_key(general.produce_level) ^ field_key(general.defence_level) ^
+                       field_key(general.mobility_level) ^ field_key(general.rest_move);
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) ret ^= field_key(general.skills_cd[i]) ^ field_key(general.skill_duration[i]);
+        return ret;
+    }
+    // 超级武器的键值只取决于其内容，因而与其在列表中的位置无关
+    static uint64_t weapon_key(const SuperWeapon& weapon) noexcept {
+        uint64_t packed = (uint64_t(weapon.type) << 56) ^ (uint64_t(uint8_t(weapon.player)) << 48) ^
+                          (uint64_t(uint16_t(weapon.cd)) << 32) ^ (uint64_t(uint16_t(weapon.rest)) << 16) ^
+                          (uint64_t(uint8_t(weapon.position.x)) << 8) ^ uint64_t(uint8_t(weapon.position.y));
+        return zobrist_mix(packed ^ 0x5bd1e9955bd1e995ULL);
+    }
 };
 
-// ******************** GameState ********************
+// 局面快照：只保存某局面相对于一个根局面被修改过的字段（以字节偏移标识）及其新值
+// 搜索分支通常只改动少量字段，故同时保留大量兄弟局面也只需每个数KB；需要读取时在根局面上临时检出
+class State_snapshot {
+public:
+    State_snapshot() noexcept = default;
+    // 从`state`与其上挂接的撤销日志生成快照，日志须完整记录了自根局面以来的所有修改
+    State_snapshot(const GameState& state, const Undo_journal& journal) noexcept {
+        const char* base = reinterpret_cast<const char*>(&state);
+        entries.reserve(journal.records.size());
+        for (const Undo_journal::Record& record : journal.records) {
+            Entry& entry = entries.emplace_back();
+            entry.offset = static_cast<const char*>(record.addr) - base;
+            entry.size = record.size;
+            assert(entry.offset + entry.size <= sizeof(GameState));
+        }
+        // 同一字段可能被修改多次，只保留一份
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.offset < b.offset || (a.offset == b.offset && a.size < b.size); });
+        entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.offset == b.offset && a.size == b.size; }), entries.end());
+        for (Entry& entry : entries) std::memcpy(&entry.value, base + entry.offset, entry.size);
+        entries.shrink_to_fit();
+    }
 
-GameState& GameState::copy_as(const GameState& other) noexcept {
-    if (this == &other) return *this;
+    // 快照记录的字段数
+    int field_count() const noexcept { return entries.size(); }
+    // 快照占用的内存字节数
+    size_t memory_usage() const noexcept { return sizeof(*this) + entries.capacity() * sizeof(Entry); }
 
-    // 复制一份新的将领列表
-    generals.clear();
-    for (const Generals* gen : other.generals) {
-        if (dynamic_cast<const MainGenerals*>(gen)) generals.push_back(new MainGenerals(*static_cast<const MainGenerals*>(gen)));
-        else if (dynamic_cast<const SubGenerals*>(gen)) generals.push_back(new SubGenerals(*static_cast<const SubGenerals*>(gen)));
-        else if (dynamic_cast<const OilWell*>(gen)) generals.push_back(new OilWell(*static_cast<const OilWell*>(gen)));
-        else assert(!"Invalid generals type");
-    }
-
-    // 其余部分直接赋值
-    round = other.round;
-    std::copy(other.coin, other.coin + PLAYER_COUNT, coin);
-    active_super_weapon = other.active_super_weapon;
-    std::copy(other.super_weapon_unlocked, other.super_weapon_unlocked + PLAYER_COUNT, super_weapon_unlocked);
-    std::copy(other.super_weapon_cd, other.super_weapon_cd + PLAYER_COUNT, super_weapon_cd);
-    memcpy(tech_level, other.tech_level, sizeof(tech_level));
-    std::copy(other.rest_move_step, other.rest_move_step + PLAYER_COUNT, rest_move_step);
-    next_generals_id = other.next_generals_id;
-    memcpy(board, other.board, sizeof(board));
-
-    // 把Cell上的将领替换一遍
-    for (int x = 0; x < Constant::col; ++x)
-        for (int y = 0; y < Constant::row; ++y) {
-            Cell& cell = this->board[x][y];
-            if (cell.generals != nullptr) {
-                cell.generals = find_general_by_id(cell.generals->id);
-                assert(cell.generals != nullptr);
-            }
+    friend class Snapshot_view;
+
+private:
+    struct Entry {
+        uint64_t value;
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::vector<Entry> entries;
+};
+
+// 在根局面上检出快照，生存期内根局面即为快照对应的局面，析构时恢复根局面
+// 可隐式转换为`const GameState&`，从而直接交给各分析器使用
+class Snapshot_view {
+public:
+    Snapshot_view(GameState& root, const State_snapshot& snapshot) noexcept : root(root), snapshot(snapshot) {
+        char* base = reinterpret_cast<char*>(&root);
+        saved.resize(snapshot.entries.size());
+        for (int i = 0, siz = snapshot.entries.size(); i < siz; ++i) {
+            const State_snapshot::Entry& entry = snapshot.entries[i];
+            std::memcpy(&saved[i], base + entry.offset, entry.size);
+            std::memcpy(base + entry.offset, &entry.value, entry.size);
         }
+    }
+    ~Snapshot_view() noexcept {
+        char* base = reinterpret_cast<char*>(&root);
+        for (int i = int(snapshot.entries.size()) - 1; i >= 0; --i)
+            std::memcpy(base + snapshot.entries[i].offset, &saved[i], snapshot.entries[i].size);
+    }
+    Snapshot_view(const Snapshot_view&) = delete;
+    Snapshot_view& operator=(const Snapshot_view&) = delete;
 
-    return *this;
+    const GameState& state() const noexcept { return root; }
+    operator const GameState&() const noexcept { return root; }
+
+private:
+    GameState& root;
+    const State_snapshot& snapshot;
+    std::vector<uint64_t> saved; // 被覆盖的原值
+};
+
+// ******************** GameState ********************
+
+uint64_t GameState::calc_zobrist() const noexcept {
+    uint64_t ret = 0;
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        const Cell& cell = board[x][y];
+        ret ^= field_key(cell.type) ^ field_key(cell.player) ^ field_key(cell.army) ^ field_key(cell.general_slot);
+    }
+    for (int i = 0; i < generals.size(); ++i) ret ^= general_key(*generals[i]);
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        ret ^= field_key(coin[p]) ^ field_key(super_weapon_unlocked[p]) ^ field_key(super_weapon_cd[p]) ^ field_key(rest_move_step[p]);
+        for (int i = 0; i < 4; ++i) ret ^= field_key(tech_level[p][i]);
+    }
+    ret ^= field_key(next_generals_id);
+    for (const SuperWeapon& weapon : active_super_weapon) ret ^= weapon_key(weapon);
+    return ret;
 }
 
-double GameState::attack_multiplier(const Coord& pos, int player) const noexcept {
-    assert(pos.in_map());
-
-    double attack = 1.0;
-    int cell_x = pos.x, cell_y = pos.y;
-    const Cell& cell = board[cell_x][cell_y];
-    if (player == std::numeric_limits<int>::min()) player = cell.player;
-
-    // 遍历cell周围至少5*5的区域，寻找里面是否有将军，他们是否使用了增益或减益技能
-    for (int i = -GENERAL_ATTACK_RADIUS; i <= GENERAL_ATTACK_RADIUS; ++i) {
-        for (int j = -GENERAL_ATTACK_RADIUS; j <= GENERAL_ATTACK_RADIUS; ++j) {
-            int x = cell_x + i;
-            int y = cell_y + j;
-            if (0 <= x && x < Constant::row && 0 <= y && y < Constant::col) {
-                const Cell &neighbor_cell = board[x][y];
-                if (neighbor_cell.generals == nullptr) continue;
-
-                if (neighbor_cell.player == player && neighbor_cell.generals->skill_duration[SkillType::COMMAND] > 0)
-                    attack *= GENERAL_SKILL_EFFECT[SkillType::COMMAND];
-                if (neighbor_cell.player != player && neighbor_cell.generals->skill_duration[SkillType::WEAKEN] > 0)
-                    attack *= GENERAL_SKILL_EFFECT[SkillType::WEAKEN];
-            }
-        }
+void GameState::rebuild_derived() noexcept {
+    zobrist = calc_zobrist();
+
+    std::fill_n(planes.player, Board_planes::SIZE, Board_planes::OUTSIDE_PLAYER);
+    std::fill_n(planes.army, Board_planes::SIZE, 0);
+    std::fill_n(planes.terrain, Board_planes::SIZE, Board_planes::OUTSIDE_TERRAIN);
+    std::fill_n(planes.general_slot, Board_planes::SIZE, -1);
+    for (Bitboard& bits : planes.owned) bits = Bitboard();
+    planes.swamp = planes.desert = planes.occupied = planes.multi_army = Bitboard();
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        Cell& cell = board[x][y];
+        cell.weapon_status = 0;
+        int idx = Board_planes::index(x, y);
+        planes.player[idx] = cell.player;
+        planes.army[idx] = cell.army;
+        planes.terrain[idx] = static_cast<int8_t>(cell.type);
+        planes.general_slot[idx] = cell.general_slot;
+
+        Coord pos(x, y);
+        if (cell.is_occupied()) planes.owned[cell.player].set(pos);
+        if (cell.type == CellType::SWAMP) planes.swamp.set(pos);
+        if (cell.type == CellType::DESERT) planes.desert.set(pos);
+        if (cell.has_general()) planes.occupied.set(pos);
+        if (cell.army > 1) planes.multi_army.set(pos);
     }
-    // 考虑gamestate中的超级武器是否被激活，（可以获取到激活的位置）该位置的军队是否会被影响
-    for (const SuperWeapon &weapon : active_super_weapon) {
-        if (weapon.type == WeaponType::ATTACK_ENHANCE && pos.in_super_weapon_range(weapon.position) && weapon.player == player) {
-            attack *= ATTACK_ENHANCE_EFFECT;
-            break;
-        }
+
+    std::fill_n(generals.id_slot, MAX_GENERALS, -1);
+    std::fill_n(generals.main_slot, PLAYER_COUNT, -1);
+    for (Slot_set& set : generals.kind_slots) set = Slot_set();
+    for (Slot_set& set : generals.player_slots) set = Slot_set();
+    generals.cooling_slots = Slot_set();
+    for (int slot = 0; slot < generals.size(); ++slot) if (generals[slot]->alive) index_general(slot, true);
+
+    std::memset(&multipliers, 0, sizeof(multipliers));
+    std::fill_n(&multipliers.attack[0][0][0], sizeof(multipliers.attack) / sizeof(double), 1.0);
+    std::fill_n(&multipliers.defence[0][0][0], sizeof(multipliers.defence) / sizeof(double), 1.0);
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) refresh_aura(Coord(x, y));
+    for (const SuperWeapon& weapon : active_super_weapon) {
+        if (weapon.type == WeaponType::ATTACK_ENHANCE) apply_enhance(weapon, 1);
+        apply_weapon_status(weapon, true);
     }
 
-    return attack;
+    std::memset(stats, 0, sizeof(stats));
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        const Cell& cell = board[x][y];
+        if (!cell.is_occupied()) continue;
+        ++stats[cell.player].cells_owned;
+        stats[cell.player].total_army += cell.army;
+    }
+    for (int slot = 0; slot < generals.size(); ++slot) count_oil_well(*generals[slot], 1);
 }
-double GameState::defence_multiplier(const Coord& pos, int player) const noexcept {
-    assert(pos.in_map());
-
-    double defence = 1.0;
-    int cell_x = pos.x, cell_y = pos.y;
-    const Cell& cell = board[cell_x][cell_y];
-    if (player == std::numeric_limits<int>::min()) player = cell.player;
-
-    // 遍历cell周围至少5*5的区域，寻找里面是否有将军，他们是否使用了增益或减益技能
-    for (int i = -GENERAL_ATTACK_RADIUS; i <= GENERAL_ATTACK_RADIUS; ++i) {
-        for (int j = -GENERAL_ATTACK_RADIUS; j <= GENERAL_ATTACK_RADIUS; ++j) {
-            int x = cell_x + i;
-            int y = cell_y + j;
-            if (0 <= x && x < Constant::row && 0 <= y && y < Constant::col) {
-                const Cell &neighbor_cell = board[x][y];
-                if (neighbor_cell.generals == nullptr) continue;
-
-                if (neighbor_cell.player == player && neighbor_cell.generals->skill_duration[SkillType::DEFENCE] > 0)
-                    defence *= GENERAL_SKILL_EFFECT[SkillType::DEFENCE];
-                if (neighbor_cell.player != player && neighbor_cell.generals->skill_duration[SkillType::WEAKEN] > 0)
-                    defence *= GENERAL_SKILL_EFFECT[SkillType::WEAKEN];
-            }
+
+void GameState::index_general(int slot, bool value) noexcept {
+    const Generals* general = generals[slot];
+    // 超出索引范围的编号不建索引，由`find_slot`逐个查找
+    if (general->id >= 0 && general->id < MAX_GENERALS) assign_derived(generals.id_slot[general->id], int16_t(value ? slot : -1));
+    if (value && general->type == GeneralType::MAIN_GENERAL && general->is_occupied() && generals.main_slot[general->player] < 0)
+        assign_derived(generals.main_slot[general->player], int16_t(slot));
+    assign_slot(generals.kind_slots[static_cast<int>(general->type)], slot, value);
+    assign_slot(generals.player_slots[general->player + 1], slot, value);
+    assign_slot(generals.cooling_slots, slot, value && general->cooling());
+}
+
+uint8_t GameState::aura_of(const Generals& general, int owner) noexcept {
+    uint8_t aura = 0;
+    if (general.skill_active(SkillType::COMMAND)) aura |= Multiplier_field::AURA_COMMAND;
+    if (general.skill_active(SkillType::DEFENCE)) aura |= Multiplier_field::AURA_DEFENCE;
+    if (general.skill_active(SkillType::WEAKEN)) aura |= Multiplier_field::AURA_WEAKEN;
+    if (aura) aura |= owner + 1;
+    return aura;
+}
+
+void GameState::refresh_aura(const Coord& pos) noexcept {
+    const Cell& cell = board[pos.x][pos.y];
+    uint8_t aura = cell.has_general() ? aura_of(*generals[cell.general_slot], cell.player) : 0;
+
+    uint8_t old_aura = multipliers.aura[pos.x][pos.y];
+    if (aura == old_aura) return;
+    if (old_aura) apply_aura(pos, old_aura, -1);
+    if (aura) apply_aura(pos, aura, 1);
+    assign_derived(multipliers.aura[pos.x][pos.y], aura);
+}
+
+void GameState::apply_aura(const Coord& center, uint8_t aura, int sign) noexcept {
+    int x_min = std::max(center.x - GENERAL_ATTACK_RADIUS, 0), x_max = std::min(center.x + GENERAL_ATTACK_RADIUS, Constant::col - 1);
+    int y_min = std::max(center.y - GENERAL_ATTACK_RADIUS, 0), y_max = std::min(center.y + GENERAL_ATTACK_RADIUS, Constant::row - 1);
+    for (int x = x_min; x <= x_max; ++x) for (int y = y_min; y <= y_max; ++y) {
+        for (int slot = 0; slot < Multiplier_field::SLOTS; ++slot) {
+            int command, defence, weaken;
+            Multiplier_field::aura_effect(aura, slot, command, defence, weaken);
+            if (command) assign_derived(multipliers.command_count[slot][x][y], multipliers.command_count[slot][x][y] + sign);
+            if (defence) assign_derived(multipliers.defence_count[slot][x][y], multipliers.defence_count[slot][x][y] + sign);
+            if (weaken) assign_derived(multipliers.weaken_count[slot][x][y], multipliers.weaken_count[slot][x][y] + sign);
         }
+        update_multiplier(x, y);
+    }
+}
+
+void GameState::apply_enhance(const SuperWeapon& weapon, int sign) noexcept {
+    assert(weapon.type == WeaponType::ATTACK_ENHANCE);
+    int slot = weapon.player + 1;
+    const Coord& center = weapon.position;
+    int x_min = std::max(center.x - SUPER_WEAPON_RADIUS, 0), x_max = std::min(center.x + SUPER_WEAPON_RADIUS, Constant::col - 1);
+    int y_min = std::max(center.y - SUPER_WEAPON_RADIUS, 0), y_max = std::min(center.y + SUPER_WEAPON_RADIUS, Constant::row - 1);
+    for (int x = x_min; x <= x_max; ++x) for (int y = y_min; y <= y_max; ++y) {
+        assign_derived(multipliers.enhance_count[slot][x][y], multipliers.enhance_count[slot][x][y] + sign);
+        update_multiplier(x, y);
     }
-    // 考虑cell上是否有general，它的防御力是否被升级
-    if (cell.generals != nullptr) defence *= cell.generals->defence_level;
-    // 考虑gamestate中的超级武器是否被激活，（可以获取到激活的位置）该位置的军队是否会被影响
-    for (const SuperWeapon &weapon : active_super_weapon) {
-        if (weapon.type == WeaponType::ATTACK_ENHANCE && pos.in_super_weapon_range(weapon.position) && weapon.player == player) {
-            defence *= ATTACK_ENHANCE_EFFECT;
-            break;
+}
+
+void GameState::apply_weapon_status(const SuperWeapon& weapon, bool value) noexcept {
+    uint8_t bit = Cell::weapon_bit(weapon.type, weapon.player);
+    int radius = weapon.type == WeaponType::TRANSMISSION ? 0 : SUPER_WEAPON_RADIUS;
+    for (int x = std::max(0, weapon.position.x - radius); x <= std::min(Constant::col - 1, weapon.position.x + radius); ++x)
+        for (int y = std::max(0, weapon.position.y - radius); y <= std::min(Constant::row - 1, weapon.position.y + radius); ++y) {
+            uint8_t& status = board[x][y].weapon_status;
+            if (bool(status & bit) != value) assign_derived(status, status ^ bit);
         }
+}
+void GameState::update_multiplier(int x, int y) noexcept {
+    for (int slot = 0; slot < Multiplier_field::SLOTS; ++slot) {
+        double attack, defence;
+        Multiplier_field::combine(multipliers.command_count[slot][x][y], multipliers.defence_count[slot][x][y],
+                                  multipliers.weaken_count[slot][x][y], multipliers.enhance_count[slot][x][y], attack, defence);
+        if (multipliers.attack[slot][x][y] != attack) assign_derived(multipliers.attack[slot][x][y], attack);
+        if (multipliers.defence[slot][x][y] != defence) assign_derived(multipliers.defence[slot][x][y], defence);
     }
+}
 
-    return defence;
+void GameState::multipliers_after_move(const Coord& from, const Coord& to, const Coord& pos, int player, double& attack, double& defence) const noexcept {
+    assert(board[from.x][from.y].has_general());
+    const int slot = player + 1;
+    int command = multipliers.command_count[slot][pos.x][pos.y];
+    int defend = multipliers.defence_count[slot][pos.x][pos.y];
+    int weaken = multipliers.weaken_count[slot][pos.x][pos.y];
+    // 撤去将领在原处的光环，再按目标格的归属计入其在新位置的光环
+    auto shift = [&](uint8_t aura, const Coord& center, int sign) {
+        if (!aura || !center.in_attack_range(pos)) return;
+        int c, d, w;
+        Multiplier_field::aura_effect(aura, slot, c, d, w);
+        command += sign * c, defend += sign * d, weaken += sign * w;
+    };
+    shift(multipliers.aura[from.x][from.y], from, -1);
+    shift(aura_of(*generals[board[from.x][from.y].general_slot], board[to.x][to.y].player), to, 1);
+    Multiplier_field::combine(command, defend, weaken, multipliers.enhance_count[slot][pos.x][pos.y], attack, defence);
 }
 
-int GameState::calc_oil_production(int player) const noexcept {
-    int ret = 0;
-    for (const Generals* gen : generals) {
-        if (dynamic_cast<const OilWell*>(gen) == nullptr || gen->player != player) continue;
-        ret += gen->produce_level;
-    }
-    return ret;
+GameState& GameState::copy_as(const GameState& other) noexcept {
+    if (this == &other) return *this;
+
+    // 将领与超级武器均内联存储，格子以槽位引用将领，故无需任何指针修复
+    // 将领池绝大部分槽位未使用，单独复制；其余部分按字节整体复制
+    Undo_journal* own_journal = journal;
+    const char* src = reinterpret_cast<const char*>(&other);
+    char* dst = reinterpret_cast<char*>(this);
+    const size_t pool_begin = reinterpret_cast<const char*>(&other.generals) - src, pool_end = pool_begin + sizeof(General_pool);
+    std::memcpy(dst, src, pool_begin);
+    generals.copy_from(other.generals);
+    std::memcpy(dst + pool_end, src + pool_end, sizeof(GameState) - pool_end);
+    journal = own_journal;
+    return *this;
 }
 
 void GameState::update_round() noexcept {
-    // 似乎要先每10回合增兵
-    if (round % 10 == 0) for (int i = 0; i < Constant::row; ++i) for (int j = 0; j < Constant::col; ++j)
-        if (board[i][j].player != -1) board[i][j].army += 1;
-
-    for (int i = 0; i < Constant::row; ++i) {
-        for (int j = 0; j < Constant::col; ++j) {
-            Cell& cell = this->board[i][j];
-            // 将军
-            Generals* general = cell.generals;
-            if (general != nullptr) general->rest_move = general->mobility_level;
-            if (dynamic_cast<MainGenerals*>(general)) cell.army += general->produce_level;
+    assert(journal == nullptr); // 回合结算不记录撤销日志
+    // 只访问本回合兵力可能变化的格子：将领所在格、流沙上未研究流沙科技一方的格子，每10回合再加上所有有归属的格子
+    // 同一格上各项结算的先后顺序与原先逐格处理时一致：10回合增兵、将领生产、流沙减兵
+    const bool reinforce = round % 10 == 0;
+    Bitboard exposed;
+    for (int p = 0; p < PLAYER_COUNT; ++p) if (!has_desert_tech(p)) exposed |= planes.owned[p];
+    const Bitboard attrition = planes.desert & exposed;
+    Bitboard touched = planes.occupied | attrition;
+    if (reinforce) touched |= planes.owned[0] | planes.owned[1];
+
+    touched.for_each([&](int bit) {
+        Coord pos = Bitboard::coord(bit);
+        Cell& cell = board[pos.x][pos.y];
+        // 似乎要先每10回合增兵
+        int delta = reinforce && cell.player >= 0;
+
+        // 将军：恢复步数并生产
+        if (cell.has_general()) {
+            Generals* general = generals[cell.general_slot];
+            assign(general->rest_move, general->mobility_level);
+            if (general->type == GeneralType::MAIN_GENERAL) delta += general->produce_level;
             // 曾经的错误：没有检查副将是否有归属
-            else if (dynamic_cast<SubGenerals*>(general) && general->is_occupied()) cell.army += general->produce_level;
-            else if (dynamic_cast<OilWell*>(general) && general->is_occupied()) coin[general->player] += general->produce_level;
-
-            // 10回合增兵后再流沙减兵
-            if (cell.type == CellType::DESERT && cell.player != -1 && cell.army > 0) {
-                if (this->tech_level[cell.player][static_cast<int>(TechType::IMMUNE_SAND)] == 0) {
-                    cell.army -= 1;
-                    if (cell.army == 0 && cell.generals == nullptr) cell.player = -1;
-                }
-            }
+            else if (general->type == GeneralType::SUB_GENERAL && general->is_occupied()) delta += general->produce_level;
+            else if (general->type == GeneralType::OIL_WELL && general->is_occupied()) assign(coin[general->player], coin[general->player] + general->produce_level);
         }
-    }
+
+        // 10回合增兵后再流沙减兵：未研究流沙科技的玩家在流沙上的有兵格子各减1
+        bool hit = attrition.test(bit) && cell.army + delta > 0;
+        delta -= hit;
+        if (delta) set_cell_army(cell, cell.army + delta);
+        if (hit && cell.army == 0 && !cell.has_general()) set_cell_player(cell, -1);
+    });
 
     // 超级武器判定
     // 【原先的错误：_i和_j的上界是开的】
@@ -661,110 +1472,75 @@ void GameState::update_round() noexcept {
                 for (int _j = std::max(0, weapon.position.y - SUPER_WEAPON_RADIUS); _j <= std::min(Constant::row - 1, weapon.position.y + SUPER_WEAPON_RADIUS); ++_j) {
                     Cell& cell = board[_i][_j];
                     if (cell.army > 0) {
-                        cell.army = std::max(0, cell.army - NUCLEAR_BOMB_DAMAGE);
-                        if (cell.army == 0 && cell.generals == nullptr) cell.player = -1;
+                        set_cell_army(cell, std::max(0, cell.army - NUCLEAR_BOMB_DAMAGE));
+                        if (cell.army == 0 && !cell.has_general()) set_cell_player(cell, -1);
                     }
                 }
             }
         }
     }
 
-    for (auto &i : this->super_weapon_cd) if (i > 0) --i;
+    for (auto &i : this->super_weapon_cd) if (i > 0) assign(i, i - 1);
 
-    for (auto &weapon : this->active_super_weapon) --weapon.rest;
+    for (auto &weapon : this->active_super_weapon) {
+        zobrist ^= weapon_key(weapon);
+        --weapon.rest;
+        zobrist ^= weapon_key(weapon);
+    }
 
-    // cd和duration 减少
-    for (Generals* gen : this->generals) {
-        for (auto &i : gen->skills_cd) if (i > 0) --i;
-        for (auto &i : gen->skill_duration) if (i > 0) --i;
+    // cd和duration 减少：只需访问技能仍在冷却或生效中的将领，全部归零后移出该集合
+    for (Generals* gen : generals.in(generals.cooling())) {
+        for (auto &i : gen->skills_cd) if (i > 0) assign(i, i - 1);
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) if (gen->skill_duration[i] > 0) set_skill_duration(*gen, i, gen->skill_duration[i] - 1);
+        if (!gen->cooling()) assign_slot(generals.cooling_slots, generals.slot_of(gen), false);
     }
 
     // 移动步数恢复
-    this->rest_move_step[0] = this->tech_level[0][0];
-    this->rest_move_step[1] = this->tech_level[1][0];
-
-    std::vector<SuperWeapon> filtered_super_weapon;
-    for (const auto& weapon : this->active_super_weapon) {
-        if (weapon.rest > 0) filtered_super_weapon.push_back(weapon);
-    }
-    this->active_super_weapon = filtered_super_weapon;
+    assign(this->rest_move_step[0], this->tech_level[0][0]);
+    assign(this->rest_move_step[1], this->tech_level[1][0]);
+
+    bool expired = false;
+    this->active_super_weapon.erase_if([&](const SuperWeapon& weapon) {
+        if (weapon.rest > 0) return false;
+        zobrist ^= weapon_key(weapon);
+        if (weapon.type == WeaponType::ATTACK_ENHANCE) apply_enhance(weapon, -1);
+        apply_weapon_status(weapon, false);
+        return expired = true;
+    });
+    // 同一玩家的同类超级武器范围可能重叠，清除后补回仍生效者
+    if (expired) for (const SuperWeapon& weapon : active_super_weapon) apply_weapon_status(weapon, true);
 
     ++this->round;
 }
 
-// ******************* MainGenerals、SubGenerals以及OilWell ********************
+// ******************* Generals ********************
 
-bool MainGenerals::production_up(GameState &gamestate, int player) noexcept {
+bool Generals::production_up(GameState &gamestate, int player) noexcept {
     int tire = production_tire();
     int cost = production_upgrade_cost();
     if (gamestate.coin[player] < cost) return false;
 
-    gamestate.coin[player] -= cost;
-    produce_level = Constant::GENERAL_PRODUCTION_VALUES[tire + 1];
+    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - cost);
+    gamestate.set_produce_level(*this, PRODUCTION_VALUE_TABLE[static_cast<int>(type)][tire + 1]);
     return true;
 }
-bool MainGenerals::defence_up(GameState &gamestate, int player) noexcept {
+bool Generals::defence_up(GameState &gamestate, int player) noexcept {
     int tire = defence_tire();
     int cost = defence_upgrade_cost();
     if (gamestate.coin[player] < cost) return false;
 
-    gamestate.coin[player] -= cost;
-    defence_level = Constant::GENERAL_DEFENCE_VALUES[tire + 1];
+    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - cost);
+    gamestate.assign(defence_level, DEFENCE_VALUE_TABLE[static_cast<int>(type)][tire + 1]);
     return true;
 }
-bool MainGenerals::movement_up(GameState &gamestate, int player) noexcept {
+bool Generals::movement_up(GameState &gamestate, int player) noexcept {
+    assert(type != GeneralType::OIL_WELL);
     int tire = movement_tire();
     int cost = movement_upgrade_cost();
     if (gamestate.coin[player] < cost) return false;
 
-    gamestate.coin[player] -= cost;
-    mobility_level = Constant::GENERAL_MOVEMENT_VALUES[tire + 1];
-    rest_move = mobility_level; // 【立即恢复移动步数（未说明的feature）】
-    return true;
-}
-bool SubGenerals::production_up(GameState &gamestate, int player) noexcept {
-    int tire = production_tire();
-    int cost = production_upgrade_cost();
-    if (gamestate.coin[player] < cost) return false;
-
-    gamestate.coin[player] -= cost;
-    produce_level = Constant::GENERAL_PRODUCTION_VALUES[tire + 1];
-    return true;
-}
-bool SubGenerals::defence_up(GameState &gamestate, int player) noexcept {
-    int tire = defence_tire();
-    int cost = defence_upgrade_cost();
-    if (gamestate.coin[player] < cost) return false;
-
-    gamestate.coin[player] -= cost;
-    defence_level = Constant::GENERAL_DEFENCE_VALUES[tire + 1];
-    return true;
-}
-bool SubGenerals::movement_up(GameState &gamestate, int player) noexcept {
-    int tire = movement_tire();
-    int cost = movement_upgrade_cost();
-    if (gamestate.coin[player] < cost) return false;
-
-    gamestate.coin[player] -= cost;
-    mobility_level = Constant::GENERAL_MOVEMENT_VALUES[tire + 1];
-    rest_move = mobility_level; // 【立即恢复移动步数（未说明的feature）】
-    return true;
-}
-bool OilWell::production_up(GameState &gamestate, int player) noexcept {
-    int tire = production_tire();
-    int cost = production_upgrade_cost();
-    if (gamestate.coin[player] < cost) return false;
-
-    gamestate.coin[player] -= cost;
-    produce_level = Constant::OILWELL_PRODUCTION_VALUES[tire + 1];
-    return true;
-}
-bool OilWell::defence_up(GameState &gamestate, int player) noexcept {
-    int tire = defence_tire();
-    int cost = defence_upgrade_cost();
-    if (gamestate.coin[player] < cost) return false;
-
-    gamestate.coin[player] -= cost;
-    defence_level = Constant::OILWELL_DEFENCE_VALUES[tire + 1];
+    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - cost);
+    gamestate.assign(mobility_level, Constant::GENERAL_MOVEMENT_VALUES[tire + 1]);
+    gamestate.assign(rest_move, mobility_level); // 【立即恢复移动步数（未说明的feature）】
     return true;
 }
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "gamestate.hpp"
+#include "binary.hpp"
+
+// 地图生成参数
+struct Map_params {
+    // 沙漠与沼泽占全图的比例
+    double desert_ratio = 0.15;
+    double swamp_ratio = 0.08;
+    // 中立副将与油井的对数，每对关于地图中心对称
+    int sub_general_pairs = 3;
+    int oil_well_pairs = 3;
+    // 主将的初始兵力
+    int main_army = 10;
+    // 中立副将与油井的初始兵力范围（闭区间）
+    int sub_army_min = 10, sub_army_max = 30;
+    int oil_army_min = 5, oil_army_max = 20;
+    // 双方的初始金币
+    int coins = 40;
+    // 双方主将之间的最小曼哈顿距离
+    int min_main_dist = Constant::col;
+};
+
+// 语料库中第`index`张地图的种子，使任一子集均可单独复现
+constexpr uint64_t map_seed(uint64_t corpus_seed, uint64_t index) noexcept {
+    return zobrist_mix(corpus_seed ^ zobrist_mix(index + 0x9e3779b97f4a7c15ULL));
+}
+
+/**
+ * @brief 由`seed`确定性地生成一张关于中心对称的初始地图，写入新构造的`state`
+ * @note 地形、将领与兵力均点对称，0号玩家的主将位于左侧；沼泽不会阻断两主将及任一将领之间的连通
+ * @note 只依赖`std::mt19937_64`的原始输出，不使用标准库分布，因而不同平台上结果一致
+ */
+void generate_map(GameState& state, uint64_t seed, const Map_params& params = Map_params()) {
+    static constexpr int MAX_ATTEMPTS = 1000;
+    const int cells = Constant::col * Constant::row;
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](int low, int high) { return low + int(rng() % uint64_t(high - low + 1)); };
+    auto random_cell = [&]() { return Coord(uniform(0, Constant::col - 1), uniform(0, Constant::row - 1)); };
+    auto mirror = [](const Coord& pos) { return Coord(Constant::col - 1 - pos.x, Constant::row - 1 - pos.y); };
+    const Coord center(Constant::col / 2, Constant::row / 2);
+
+    // 在`allowed`内成对扩张`area`至`target`格，多数新格与已有区域相邻以形成成片地形
+    auto grow = [&](Bitboard& area, int target, const Bitboard& allowed) {
+        target = std::min(target, allowed.count());
+        for (int tries = 0; area.count() < target && tries < cells * 100; ++tries) {
+            Coord pos = random_cell();
+            if (!allowed.test(pos) || area.test(pos)) continue;
+            if (area.any() && uniform(0, 9) < 7 && !area.dilate().test(pos)) continue;
+            area.set(pos);
+            area.set(mirror(pos));
+        }
+    };
+
+    struct Placement { GeneralType type; int player; Coord pos; int army; };
+    std::vector<Placement> generals;
+    Bitboard desert, swamp;
+    for (int attempt = 0; ; ++attempt) {
+        if (attempt >= MAX_ATTEMPTS) throw std::runtime_error("Cannot generate map with given params");
+        generals.clear();
+        desert = swamp = Bitboard();
+
+        // 主将位于左侧三分之一，不贴边
+        Coord main_pos(uniform(1, std::max(1, Constant::col / 3)), uniform(1, Constant::row - 2));
+        if (main_pos.dist_to(mirror(main_pos)) < params.min_main_dist) continue;
+        generals.push_back({GeneralType::MAIN_GENERAL, 0, main_pos, params.main_army});
+        generals.push_back({GeneralType::MAIN_GENERAL, 1, mirror(main_pos), params.main_army});
+
+        // 主将周围保持平原
+        Bitboard home = Bitboard::square(main_pos, 1) | Bitboard::square(mirror(main_pos), 1);
+        grow(desert, int(cells * params.desert_ratio), ~home);
+        grow(swamp, int(cells * params.swamp_ratio), ~(home | desert));
+
+        // 中立将领不在沼泽上、不在中心、不在主将攻击范围内
+        Bitboard free = ~(swamp | Bitboard::single(center) |
+                          Bitboard::square(main_pos, GENERAL_ATTACK_RADIUS) | Bitboard::square(mirror(main_pos), GENERAL_ATTACK_RADIUS));
+        auto place_pairs = [&](GeneralType type, int pairs, int army_min, int army_max) {
+            for (int placed = 0, tries = 0; placed < pairs && tries < cells * 10; ++tries) {
+                Coord pos = random_cell();
+                if (!free.test(pos) || !free.test(mirror(pos))) continue;
+                int army = uniform(army_min, army_max);
+                generals.push_back({type, -1, pos, army});
+                generals.push_back({type, -1, mirror(pos), army});
+                free.reset(pos);
+                free.reset(mirror(pos));
+                ++placed;
+            }
+        };
+        place_pairs(GeneralType::SUB_GENERAL, params.sub_general_pairs, params.sub_army_min, params.sub_army_max);
+        place_pairs(GeneralType::OIL_WELL, params.oil_well_pairs, params.oil_army_min, params.oil_army_max);
+        if (int(generals.size()) != 2 * (1 + params.sub_general_pairs + params.oil_well_pairs)) continue;
+
+        // 所有将领须在不经过沼泽的情况下互相可达
+        Bitboard reach = Bitboard::single(main_pos).flood_fill(~swamp);
+        bool connected = true;
+        for (const Placement& general : generals) connected = connected && reach.test(general.pos);
+        if (connected) break;
+    }
+
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        Cell& cell = state.board[x][y];
+        Coord pos(x, y);
+        cell.type = swamp.test(pos) ? CellType::SWAMP : desert.test(pos) ? CellType::DESERT : CellType::PLAIN;
+        cell.player = -1;
+        cell.army = 0;
+        cell.position = pos;
+    }
+    for (const Placement& general : generals) {
+        Cell& cell = state[general.pos];
+        cell.player = general.player;
+        cell.army = general.army;
+        cell.general_slot = state.generals.emplace(general.type, state.next_generals_id++, general.player, general.pos);
+    }
+    state.coin[0] = state.coin[1] = params.coins;
+    // 以上直接改写了状态，需重建派生数据
+    state.rebuild_derived();
+}
+
+/**
+ * @brief 将初始局面写为评测机的初始化JSON（单行，不含换行符），可直接由`parse_init_map`读回
+ * @param seat 写入`Player`字段的座次
+ */
+std::string init_map_json(const GameState& state, int seat) {
+    std::string ret = "{\"Player\":" + std::to_string(seat) + ",\"Cells\":[";
+    std::string types;
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        const Cell& cell = state.board[x][y];
+        if (x || y) ret += ',';
+        ret += wrap("[[%d,%d],%d,%d]", x, y, int(cell.player), cell.army);
+        types += char('0' + static_cast<int>(cell.type));
+    }
+    ret += "],\"Cell_type\":\"" + types + "\",\"Generals\":[";
+    bool first = true;
+    for (const Generals* general : state.generals) {
+        if (!first) ret += ',';
+        first = false;
+        ret += wrap("{\"Id\":%d,\"Player\":%d,\"Type\":%d,\"Position\":[%d,%d]}",
+                    general->id, general->player, static_cast<int>(general->type) + 1, general->position.x, general->position.y);
+    }
+    ret += wrap("],\"Coins\":[%d,%d]}", state.coin[0], state.coin[1]);
+    return ret;
+}
+
+/**
+ * @brief 初始局面的紧凑二进制形式：尺寸、金币、每格2位的地形、有兵或有归属的格子（下标差分）及将领
+ * @note 只记录初始地图所含的信息，将领等级、技能与科技等均按初始值处理
+ */
+void encode_map(const GameState& state, Byte_writer& out) {
+    out.u8(Constant::col);
+    out.u8(Constant::row);
+    out.varint(state.coin[0]);
+    out.varint(state.coin[1]);
+
+    const int cells = Constant::col * Constant::row;
+    for (int base = 0; base < cells; base += 4) {
+        uint8_t packed = 0;
+        for (int i = base; i < std::min(base + 4, cells); ++i)
+            packed |= static_cast<int>(state.board[i / Constant::row][i % Constant::row].type) << (2 * (i - base));
+        out.u8(packed);
+    }
+
+    int count = 0;
+    for (int i = 0; i < cells; ++i) {
+        const Cell& cell = state.board[i / Constant::row][i % Constant::row];
+        count += cell.army || cell.player >= 0;
+    }
+    out.varint(count);
+    for (int i = 0, last = 0; i < cells; ++i) {
+        const Cell& cell = state.board[i / Constant::row][i % Constant::row];
+        if (!cell.army && cell.player < 0) continue;
+        out.varint(i - last);
+        out.u8(cell.player + 1);
+        out.varint(cell.army);
+        last = i;
+    }
+
+    out.varint(state.generals.size());
+    for (const Generals* general : state.generals) {
+        out.u8(static_cast<int>(general->type) | (general->player + 1) << 2);
+        out.varint(general->id);
+        out.u8(general->position.x);
+        out.u8(general->position.y);
+    }
+}
+// 读取`encode_map`的输出，写入新构造的`state`
+void decode_map(GameState& state, Byte_reader& in) {
+    if (in.u8() != Constant::col || in.u8() != Constant::row) throw std::runtime_error("Map size mismatch");
+    state.coin[0] = int(in.varint());
+    state.coin[1] = int(in.varint());
+
+    const int cells = Constant::col * Constant::row;
+    for (int base = 0; base < cells; base += 4) {
+        uint8_t packed = in.u8();
+        for (int i = base; i < std::min(base + 4, cells); ++i) {
+            Cell& cell = state.board[i / Constant::row][i % Constant::row];
+            cell.type = CellType((packed >> (2 * (i - base))) & 3);
+            cell.player = -1;
+            cell.army = 0;
+            cell.position = Coord(i / Constant::row, i % Constant::row);
+        }
+    }
+
+    for (int count = int(in.varint()), i = 0; count > 0; --count) {
+        i += int(in.varint());
+        if (i >= cells) throw std::runtime_error("Cell index out of range");
+        Cell& cell = state.board[i / Constant::row][i % Constant::row];
+        cell.player = int(in.u8()) - 1;
+        cell.army = int(in.varint());
+    }
+
+    for (int count = int(in.varint()); count > 0; --count) {
+        uint8_t tag = in.u8();
+        int id = int(in.varint());
+        int x = in.u8(), y = in.u8();
+        Coord pos(x, y);
+        if (!pos.in_map()) throw std::runtime_error("General position out of range");
+        if (state.generals.full()) throw std::runtime_error("Too many generals");
+        state[pos].general_slot = state.generals.emplace(GeneralType(tag & 3), id, int(tag >> 2) - 1, pos);
+        state.next_generals_id = std::max(state.next_generals_id, id + 1);
+    }
+    // 以上直接改写了状态，需重建派生数据
+    state.rebuild_derived();
+}
+
+// 二进制地图库的文件头，其后依次为地图数与各张地图的`encode_map`输出
+constexpr char MAP_CORPUS_MAGIC[4] = {'G', 'M', 'A', 'P'};
+
+/**
+ * @brief 读取地图库，返回各地图的初始化JSON（`Player`字段为0）
+ * @note 以`MAP_CORPUS_MAGIC`开头的文件按二进制格式读取，否则视为每行一个初始化JSON
+ */
+std::vector<std::string> load_map_corpus(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<std::string> maps;
+    if (content.compare(0, sizeof(MAP_CORPUS_MAGIC), MAP_CORPUS_MAGIC, sizeof(MAP_CORPUS_MAGIC)) == 0) {
+        Byte_reader in(content.data() + sizeof(MAP_CORPUS_MAGIC), content.size() - sizeof(MAP_CORPUS_MAGIC));
+        for (uint64_t count = in.varint(); count > 0; --count) {
+            GameState state;
+            decode_map(state, in);
+            maps.push_back(init_map_json(state, 0));
+        }
+        return maps;
+    }
+    for (size_t begin = 0, end; begin < content.size(); begin = end + 1) {
+        end = std::min(content.find('\n', begin), content.size());
+        if (end > begin) maps.push_back(content.substr(begin, end - begin));
+    }
+    return maps;
+}
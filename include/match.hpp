@@ -0,0 +1,286 @@
+#pragma once
+
+#include <map>
+#include <cerrno>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include "json.hpp"
+#include "operation.hpp"
+#include "gamestate.hpp"
+#include "protocol.hpp"
+#include "util.hpp"
+#include "simulate.hpp"
+#include "replay.hpp"
+
+// 本地对局的配置
+struct Match_config {
+    // 回合上限，达到后按总兵力判定胜负
+    int max_rounds = 500;
+    // 每回合的时间限制（毫秒），自对方操作转发完毕时起算
+    int time_limit_ms = 1000;
+    // 首回合额外允许的时间（毫秒），用于进程启动与读入地图
+    int startup_grace_ms = 1000;
+    // 单条消息的长度上限，超出视为非法输出
+    int max_message_size = 1 << 20;
+};
+
+// 对局结束的原因
+enum class End_reason : int {
+    CAPTURED,     // 主将被俘
+    ROUND_LIMIT,  // 达到回合上限
+    TIMEOUT,      // 一方超时
+    CRASHED,      // 一方进程退出或输出格式错误
+    INVALID_OP,   // 一方发出非法操作
+    REFEREE_ERROR // 裁判进程异常退出
+};
+const char* end_reason_str(End_reason reason) noexcept {
+    static constexpr const char* table[] = {"captured", "round_limit", "timeout", "crashed", "invalid_op", "referee_error"};
+    return table[static_cast<int>(reason)];
+}
+
+// 单局结果
+struct Match_result {
+    // 获胜方座次，平局为-1
+    int winner;
+    // 结束时的回合数
+    int rounds;
+    End_reason reason;
+    // 超时、崩溃或发出非法操作的一方座次，其余情况为-1
+    int culprit;
+};
+
+// 以管道连接标准输入输出的bot子进程，析构时强制结束
+class Bot_process {
+public:
+    enum class Read_status { OK, TIMEOUT, CLOSED, MALFORMED };
+
+    /**
+     * @brief 启动bot进程
+     * @param path 可执行文件路径
+     * @param log_path 标准错误的重定向目标，为空时丢弃
+     * @note 子进程在父进程退出时会被一并结束
+     */
+    Bot_process(const std::string& path, const std::string& log_path) {
+        int to_child[2], from_child[2];
+        if (pipe2(to_child, O_CLOEXEC) || pipe2(from_child, O_CLOEXEC)) throw std::runtime_error("pipe2 failed");
+        int err_fd = open(log_path.empty() ? "/dev/null" : log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (err_fd < 0) throw std::runtime_error("Cannot open bot log: " + log_path);
+
+        pid = fork();
+        if (pid < 0) throw std::runtime_error("fork failed");
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            signal(SIGPIPE, SIG_DFL);
+            dup2(to_child[0], STDIN_FILENO);
+            dup2(from_child[1], STDOUT_FILENO);
+            dup2(err_fd, STDERR_FILENO);
+            execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(to_child[0]);
+        close(from_child[1]);
+        close(err_fd);
+        in_fd = to_child[1];
+        out_fd = from_child[0];
+    }
+    Bot_process(const Bot_process&) = delete;
+    Bot_process& operator=(const Bot_process&) = delete;
+    ~Bot_process() noexcept {
+        close(in_fd);
+        close(out_fd);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+
+    // 向bot的标准输入写入全部数据，对方已退出时返回false
+    bool send(const std::string& data) noexcept {
+        for (size_t done = 0; done < data.size(); ) {
+            ssize_t ret = write(in_fd, data.data() + done, data.size() - done);
+            if (ret < 0 && errno == EINTR) continue;
+            if (ret <= 0) return false;
+            done += ret;
+        }
+        return true;
+    }
+
+    // 在`deadline`之前读取一条带4字节大端长度头的消息（即`write_to_judger`的输出）
+    Read_status receive(std::string& msg, std::chrono::steady_clock::time_point deadline, int max_size) noexcept {
+        unsigned char header[4];
+        Read_status status = read_exact(reinterpret_cast<char*>(header), 4, deadline);
+        if (status != Read_status::OK) return status;
+        uint32_t size = uint32_t(header[0]) << 24 | uint32_t(header[1]) << 16 | uint32_t(header[2]) << 8 | header[3];
+        if (size > uint32_t(max_size)) return Read_status::MALFORMED;
+        msg.resize(size);
+        return read_exact(msg.data(), size, deadline);
+    }
+
+private:
+    pid_t pid;
+    int in_fd;
+    int out_fd;
+
+    Read_status read_exact(char* buf, size_t size, std::chrono::steady_clock::time_point deadline) noexcept {
+        for (size_t done = 0; done < size; ) {
+            auto rest = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (rest <= 0) return Read_status::TIMEOUT;
+            pollfd pfd{out_fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, int(rest));
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) return Read_status::TIMEOUT;
+            ssize_t ret = read(out_fd, buf + done, size - done);
+            if (ret < 0 && errno == EINTR) continue;
+            if (ret <= 0) return Read_status::CLOSED;
+            done += ret;
+        }
+        return Read_status::OK;
+    }
+};
+
+/**
+ * @brief 解析bot发出的一条操作消息（若干操作行，以单独的`8`行结束）
+ * @return bool 格式是否正确；参数个数或取值非法的操作也视为格式错误
+ */
+bool parse_bot_message(const std::string& msg, std::vector<Operation>& ops) {
+    ops.clear();
+    Operation op;
+    for (size_t begin = 0; begin < msg.size(); ) {
+        size_t end = std::min(msg.find('\n', begin), msg.size());
+        int code = parse_operation(std::string_view(msg).substr(begin, end - begin), op);
+        begin = end + 1;
+        if (code == OPERATION_END) return begin >= msg.size();
+        if (code < 0 || !op.well_formed()) return false;
+        ops.push_back(op);
+    }
+    return false;
+}
+
+/**
+ * @brief 在`map_line`给出的地图上进行一局对局
+ * @param map_line 评测机格式的初始化行（JSON），其中的`Player`字段会按座次改写
+ * @param bots 按座次排列的bot可执行文件路径
+ * @param logs 按座次排列的bot标准错误重定向路径，为空时丢弃
+ * @param replay_path 回放的保存路径，为空时不记录
+ * @note 与评测机一致：先读取0号玩家的操作并转发给1号玩家，再读取1号玩家的操作并转发给0号玩家，然后进行回合结算
+ */
+Match_result play_match(const Match_config& config, const std::string& map_line, const std::string (&bots)[PLAYER_COUNT],
+                        const std::string (&logs)[PLAYER_COUNT], const std::string& replay_path = "") {
+    GameState state;
+    parse_init_map(state, map_line);
+    std::unique_ptr<Replay_writer> replay;
+    if (!replay_path.empty()) replay = std::make_unique<Replay_writer>(state);
+
+    nlohmann::json init = nlohmann::json::parse(map_line);
+    std::unique_ptr<Bot_process> process[PLAYER_COUNT];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.time_limit_ms + config.startup_grace_ms);
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        process[p] = std::make_unique<Bot_process>(bots[p], logs[p]);
+        init["Player"] = p;
+        process[p]->send(init.dump() + "\n");
+    }
+
+    // 本回合双方已执行的操作
+    std::vector<Operation> executed[PLAYER_COUNT];
+    auto record_round = [&]() {
+        if (replay) replay->add_round(executed[0].data(), executed[0].size(), executed[1].data(), executed[1].size(), state);
+    };
+    // 结束对局并写出回放；`settled`为假表示在回合中途结束，此时补记未完成的回合
+    auto conclude = [&](const Match_result& result, bool settled) {
+        if (!replay) return result;
+        if (!settled) record_round();
+        save_replay(replay_path, replay->finish(result.winner, !settled));
+        return result;
+    };
+    auto fault = [&](End_reason reason, int culprit) { return conclude(Match_result{1 - culprit, state.round, reason, culprit}, false); };
+
+    std::string msg;
+    std::vector<Operation> ops;
+    for (int round = 1; round <= config.max_rounds; ++round) {
+        for (std::vector<Operation>& list : executed) list.clear();
+        for (int p = 0; p < PLAYER_COUNT; ++p) {
+            switch (process[p]->receive(msg, deadline, config.max_message_size)) {
+                case Bot_process::Read_status::OK: break;
+                case Bot_process::Read_status::TIMEOUT: return fault(End_reason::TIMEOUT, p);
+                default: return fault(End_reason::CRASHED, p);
+            }
+            if (!parse_bot_message(msg, ops)) return fault(End_reason::CRASHED, p);
+
+            for (const Operation& op : ops) {
+                if (!execute_operation(state, p, op, false)) return fault(End_reason::INVALID_OP, p);
+                executed[p].push_back(op);
+                int loser = captured_player(state);
+                if (loser >= 0) return conclude(Match_result{1 - loser, state.round, End_reason::CAPTURED, -1}, false);
+            }
+            // 对方已退出时写入失败，留待读取其操作时判负
+            process[1 - p]->send(msg);
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.time_limit_ms);
+        }
+        state.update_round();
+        record_round();
+    }
+
+    // 达到回合上限：总兵力多者胜
+    int army0 = state.total_army(0), army1 = state.total_army(1);
+    return conclude(Match_result{army0 == army1 ? -1 : army0 > army1 ? 0 : 1, config.max_rounds, End_reason::ROUND_LIMIT, -1}, true);
+}
+
+/**
+ * @brief 以进程池运行`count`局对局，同时至多`jobs`局
+ * @param play 在独立的裁判子进程中执行，给出第`game`局的结果
+ * @param on_result 在本进程中按完成顺序调用
+ * @note 每局由单独fork出的裁判进程负责：某局裁判崩溃不影响其他对局，裁判退出时其bot子进程也随之结束
+ */
+void run_matches(int count, int jobs, const std::function<Match_result(int game)>& play,
+                 const std::function<void(int game, const Match_result&)>& on_result) {
+    // 运行中的裁判进程 -> (对局编号, 结果管道)
+    std::map<pid_t, std::pair<int, int>> running;
+    int next = 0;
+    while (next < count || !running.empty()) {
+        while (next < count && int(running.size()) < jobs) {
+            int result_pipe[2];
+            if (pipe2(result_pipe, O_CLOEXEC)) throw std::runtime_error("pipe2 failed");
+            pid_t pid = fork();
+            if (pid < 0) throw std::runtime_error("fork failed");
+            if (pid == 0) {
+                close(result_pipe[0]);
+                try {
+                    Match_result result = play(next);
+                    ssize_t written = write(result_pipe[1], &result, sizeof(result));
+                    _exit(written == sizeof(result) ? 0 : 1);
+                } catch (...) {
+                    _exit(1);
+                }
+            }
+            close(result_pipe[1]);
+            running[pid] = {next++, result_pipe[0]};
+        }
+
+        pid_t pid = waitpid(-1, nullptr, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("waitpid failed");
+        }
+        auto it = running.find(pid);
+        if (it == running.end()) continue;
+        auto [game, fd] = it->second;
+        running.erase(it);
+
+        // 结果小于管道缓冲区，裁判退出前已完整写入
+        Match_result result{-1, 0, End_reason::REFEREE_ERROR, -1};
+        if (read(fd, &result, sizeof(result)) != sizeof(result)) result = Match_result{-1, 0, End_reason::REFEREE_ERROR, -1};
+        close(fd);
+        on_result(game, result);
+    }
+}
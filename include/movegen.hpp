@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+
+#include "operation.hpp"
+#include "gamestate.hpp"
+#include "util.hpp"
+
+// 操作生成的过滤条件
+struct Move_filter {
+    // 按`OperationType`取位的掩码，只生成对应位为1的操作类型
+    uint32_t type_mask;
+    // 操作的锚点须位于此范围内：军队移动、将领移动、升级与技能的锚点为发起格，超级武器与召唤的锚点为目标格
+    Bitboard region;
+    // 是否枚举军队移动的所有出兵数，否则只生成全部出兵（兵力-1）
+    bool all_army_counts;
+
+    static constexpr uint32_t ALL_TYPES = ~0u;
+    static uint32_t type_bit(OperationType type) noexcept { return 1u << static_cast<int>(type); }
+
+    Move_filter(uint32_t type_mask = ALL_TYPES, const Bitboard& region = Bitboard::FULL, bool all_army_counts = false) noexcept :
+        type_mask(type_mask), region(region), all_army_counts(all_army_counts) {}
+
+    bool accepts(OperationType type) const noexcept { return type_mask & type_bit(type); }
+};
+
+/**
+ * @brief 枚举`player`在`state`下的所有合法操作，写入调用者提供的缓冲区，不修改状态
+ * @param buffer 输出缓冲区，容量为`capacity`，写满后停止生成
+ * @return int 写入的操作数
+ * @note 合法性与`execute_operation`一致，但不生成以下无实际效果或依赖实现漏洞的操作：
+ *       将领原地移动、起点与落点相同的传送
+ */
+int generate_operations(const GameState& state, int player, Operation* buffer, int capacity, const Move_filter& filter = Move_filter()) noexcept {
+    assert(player == 0 || player == 1);
+    int count = 0;
+    auto emit = [&](const Operation& op) noexcept {
+        if (count >= capacity) return false;
+        buffer[count++] = op;
+        return true;
+    };
+
+    const Board_planes& planes = state.planes;
+    const int coin = state.coin[player];
+    const bool swamp_tech = state.has_swamp_tech(player);
+    const Bitboard owned = planes.owned[player];
+    // 不受传送眩晕与时间暂停影响，可以发起行动的格子
+    auto can_act = [&](const Cell& cell) noexcept {
+        return !cell.weapon_active(WeaponType::TRANSMISSION, player) && !cell.weapon_active(WeaponType::TIME_STOP);
+    };
+    auto can_enter = [&](const Cell& cell) noexcept { return swamp_tech || cell.type != CellType::SWAMP; };
+
+    bool full = false;
+    // 军队移动
+    if (filter.accepts(OperationType::MOVE_ARMY) && state.rest_move_step[player] > 0)
+        (owned & planes.multi_army & filter.region).for_each([&](int bit) {
+            if (full) return;
+            Coord pos = Bitboard::coord(bit);
+            const Cell& cell = state[pos];
+            if (!can_act(cell)) return;
+
+            for (int dir = 0; dir < DIRECTION_COUNT && !full; ++dir) {
+                Coord next_pos = pos + DIRECTION_ARR[dir];
+                if (!next_pos.in_map() || !can_enter(state[next_pos])) continue;
+                for (int num = filter.all_army_counts ? 1 : cell.army - 1; num < cell.army && !full; ++num)
+                    full = !emit(Operation::move_army(pos, static_cast<Direction>(dir), num));
+            }
+        });
+
+    // 将领相关：移动、升级与技能，锚点为将领所在格
+    (owned & planes.occupied & filter.region).for_each([&](int bit) {
+        if (full) return;
+        Coord pos = Bitboard::coord(bit);
+        const Cell& cell = state[pos];
+        const Generals* general = state.generals[cell.general_slot];
+        bool is_oil_well = general->type == GeneralType::OIL_WELL;
+
+        // 升级不受超级武器影响
+        if (filter.accepts(OperationType::UPDATE_GENERALS)) {
+            if (coin >= general->production_upgrade_cost()) full = full || !emit(Operation::upgrade_generals(general->id, QualityType::PRODUCTION));
+            if (coin >= general->defence_upgrade_cost()) full = full || !emit(Operation::upgrade_generals(general->id, QualityType::DEFENCE));
+            if (!is_oil_well && coin >= general->movement_upgrade_cost()) full = full || !emit(Operation::upgrade_generals(general->id, QualityType::MOBILITY));
+        }
+        if (full || !can_act(cell)) return;
+
+        // 移动：与`check_general_movement`相同的逐层洪泛，只经过己方无将领的格子
+        if (filter.accepts(OperationType::MOVE_GENERALS) && !is_oil_well) {
+            Bitboard passable = owned & ~planes.occupied;
+            if (!swamp_tech) passable &= ~planes.swamp;
+            Bitboard reached = Bitboard::single(pos), frontier = reached;
+            for (int step = 0; step < general->rest_move && frontier.any(); ++step) {
+                frontier = frontier.dilate() & passable & ~reached;
+                reached |= frontier;
+            }
+            reached.reset(pos);
+            reached.for_each([&](int dest) {
+                if (!full) full = !emit(Operation::move_generals(general->id, Bitboard::coord(dest)));
+            });
+        }
+
+        // 技能：突袭与突破需要目标格，其余技能没有
+        if (filter.accepts(OperationType::USE_GENERAL_SKILLS)) for (int i = 0; i < GENERAL_SKILL_COUNT && !full; ++i) {
+            SkillType skill = static_cast<SkillType>(i);
+            if (coin < skill.cost() || general->skills_cd[i] > 0) continue;
+            if (skill != SkillType::RUSH && skill != SkillType::STRIKE) {
+                full = !emit(Operation::generals_skill(general->id, skill));
+                continue;
+            }
+            (Bitboard::square(pos, GENERAL_ATTACK_RADIUS)).for_each([&](int dest) {
+                if (full) return;
+                Coord dest_pos = Bitboard::coord(dest);
+                if (skill == SkillType::RUSH && !check_rush_param(player, dest_pos, pos, state)) return;
+                full = !emit(Operation::generals_skill(general->id, skill, dest_pos));
+            });
+        }
+    });
+
+    // 科技升级
+    if (!full && filter.accepts(OperationType::UPDATE_TECH)) {
+        const int* level = state.tech_level[player];
+        int mobility = level[static_cast<int>(TechType::MOBILITY)];
+        for (int i = 0; i + 1 < PLAYER_MOVEMENT_LEVELS; ++i)
+            if (mobility == PLAYER_MOVEMENT_VALUES[i] && coin >= PLAYER_MOVEMENT_COST[i]) full = full || !emit(Operation::upgrade_tech(TechType::MOBILITY));
+        if (!level[static_cast<int>(TechType::IMMUNE_SWAMP)] && coin >= swamp_immunity) full = full || !emit(Operation::upgrade_tech(TechType::IMMUNE_SWAMP));
+        if (!level[static_cast<int>(TechType::IMMUNE_SAND)] && coin >= sand_immunity) full = full || !emit(Operation::upgrade_tech(TechType::IMMUNE_SAND));
+        if (!level[static_cast<int>(TechType::UNLOCK)] && coin >= unlock_super_weapon) full = full || !emit(Operation::upgrade_tech(TechType::UNLOCK));
+    }
+
+    // 超级武器，锚点为目标格
+    if (!full && filter.accepts(OperationType::USE_SUPERWEAPON) && state.super_weapon_unlocked[player] && state.super_weapon_cd[player] == 0) {
+        static constexpr WeaponType AREA_WEAPONS[] = {WeaponType::NUCLEAR_BOOM, WeaponType::ATTACK_ENHANCE, WeaponType::TIME_STOP};
+        for (WeaponType type : AREA_WEAPONS) filter.region.for_each([&](int bit) {
+            if (!full) full = !emit(Operation::use_superweapon(type, Bitboard::coord(bit)));
+        });
+
+        // 传送：从己方兵力大于1的格子传送至无将领且可进入的格子
+        (filter.region & ~planes.occupied).for_each([&](int bit) {
+            if (full) return;
+            Coord to = Bitboard::coord(bit);
+            if (!can_enter(state[to])) return;
+            (owned & planes.multi_army).for_each([&](int from) {
+                if (!full && from != bit) full = !emit(Operation::use_superweapon(WeaponType::TRANSMISSION, to, Bitboard::coord(from)));
+            });
+        });
+    }
+
+    // 召唤副将
+    if (!full && filter.accepts(OperationType::CALL_GENERAL) && coin >= SPAWN_GENERAL_COST && !state.generals.full())
+        (owned & ~planes.occupied & filter.region).for_each([&](int bit) {
+            if (!full) full = !emit(Operation::recruit_generals(Bitboard::coord(bit)));
+        });
+
+    return count;
+}
+
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <vector>
+#include <memory_resource>
 
 #include "gamestate.hpp"
 
@@ -70,6 +71,34 @@ public:
         return result;
     }
 
+    // 参数个数与取值范围是否合法（不检查与局面相关的合法性），用于校验外部输入
+    bool well_formed() const noexcept {
+        auto in_map = [&](int i) { return operand_count > i + 1 && Coord(operand[i], operand[i + 1]).in_map(); };
+        auto in_range = [&](int i, int low, int high) { return operand_count > i && operand[i] >= low && operand[i] <= high; };
+        switch (opcode) {
+            case OperationType::MOVE_ARMY:
+                return operand_count == 4 && in_map(0) && in_range(2, 1, DIRECTION_COUNT) && operand[3] > 0;
+            case OperationType::MOVE_GENERALS:
+                return operand_count == 3 && in_map(1);
+            case OperationType::UPDATE_GENERALS:
+                return operand_count == 2 && in_range(1, 1, 3);
+            case OperationType::USE_GENERAL_SKILLS:
+                // 突袭与突破需要目标格，其余技能的目标格可省略
+                if (!in_range(1, 1, GENERAL_SKILL_COUNT)) return false;
+                return operand[1] <= 2 ? operand_count == 4 && in_map(2) : operand_count == 2 || operand_count == 4;
+            case OperationType::UPDATE_TECH:
+                return operand_count == 1 && in_range(0, 1, 4);
+            case OperationType::USE_SUPERWEAPON:
+                // 传送还需要起点
+                if (!in_range(0, 1, 4) || !in_map(1)) return false;
+                return operand[0] == 3 ? operand_count == 5 && in_map(3) : operand_count == 3 || operand_count == 5;
+            case OperationType::CALL_GENERAL:
+                return operand_count == 2 && in_map(0);
+            default:
+                return false;
+        }
+    }
+
     std::string stringize() const noexcept {
         std::string result = std::to_string(int(opcode)) + " ";
         for (int i = 0; i < operand_count; ++i) result += std::to_string(operand[i]) + " ";
@@ -114,20 +143,19 @@ public:
     int player;
     // 抽象的分数，可用于排序等
     double score;
-    // 操作列表
-    std::vector<Operation> ops;
+    // 操作列表，可指定内存资源（如单回合分配区）
+    std::pmr::vector<Operation> ops;
 
-    Operation_list(int player) noexcept : player(player) {}
-    Operation_list(int player, const std::vector<Operation>& ops) noexcept : player(player), ops(ops) {}
-    Operation_list(int player, std::vector<Operation>&& ops) noexcept : player(player), ops(std::move(ops)) {}
+    Operation_list(int player, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept : player(player), ops(resource) {}
+    Operation_list(int player, const std::vector<Operation>& ops) noexcept : player(player), ops(ops.begin(), ops.end()) {}
 
     // 取值函数与迭代函数
     Operation& operator[](int index) noexcept { return ops[index]; }
     const Operation& operator[](int index) const noexcept { return ops[index]; }
-    std::vector<Operation>::iterator begin() noexcept { return ops.begin(); }
-    std::vector<Operation>::iterator end() noexcept { return ops.end(); }
-    std::vector<Operation>::const_iterator begin() const noexcept { return ops.begin(); }
-    std::vector<Operation>::const_iterator end() const noexcept { return ops.end(); }
+    std::pmr::vector<Operation>::iterator begin() noexcept { return ops.begin(); }
+    std::pmr::vector<Operation>::iterator end() noexcept { return ops.end(); }
+    std::pmr::vector<Operation>::const_iterator begin() const noexcept { return ops.begin(); }
+    std::pmr::vector<Operation>::const_iterator end() const noexcept { return ops.end(); }
 
     bool operator> (const Operation_list& other) const noexcept { return score > other.score; }
 
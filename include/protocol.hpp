@@ -2,21 +2,27 @@
 
 #include <vector>
 #include <tuple>
-#include <iostream>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include <unistd.h>
 
 #include "json.hpp"
 #include "operation.hpp"
 #include "gamestate.hpp"
 
 /**
- * @brief 读取初始地图及先后手信息
+ * @brief 以JSON DOM解析初始地图及先后手信息，作为`Init_map_parser`的后备
+ * @param s 评测机发送的初始化行（JSON）
  * @return int 先后手编号
  */
-int read_init_map(GameState& gamestate) {
-    std::string s;
-    getline(std::cin, s);
-
-    auto d = nlohmann::json::parse(s);
+int parse_init_map_dom(GameState& gamestate, std::string_view s) {
+    auto d = nlohmann::json::parse(s.begin(), s.end());
     int my_seat = d["Player"];
     auto map = d["Cells"], generals = d["Generals"], coins = d["Coins"];
     std::string types = d["Cell_type"].dump();
@@ -39,75 +45,333 @@ int read_init_map(GameState& gamestate) {
         Coord position{int(generals[i]["Position"][0]), int(generals[i]["Position"][1])};
         Cell& cell = gamestate[position];
 
-        switch (int(generals[i]["Type"])) {
-        case 1:
-            cell.generals = new MainGenerals(id, player, position);
-            break;
-        case 2:
-            cell.generals = new SubGenerals(id, player, position);
-            break;
-        case 3:
-            cell.generals = new OilWell(id, player, position);
-            break;
-        default:
-            assert(false);
-        }
-        gamestate.generals.push_back(cell.generals);
+        // `Type`字段为1~3，依次对应主将、副将与油井
+        int type = int(generals[i]["Type"]);
+        assert(type >= 1 && type <= 3);
+        cell.general_slot = gamestate.generals.emplace(GeneralType(type - 1), id, player, position);
     }
+    // 以上直接改写了状态，需重建派生数据
+    gamestate.rebuild_derived();
     return my_seat;
 }
 /**
- * @brief 读取敌方操作列表
- * @return a vector of operations
+ * @brief 初始化消息的单遍解析器：直接从输入缓冲区填写`GameState`与先后手，不构造JSON DOM
+ * @note 只接受评测机实际使用的JSON子集（整数、不含转义的字符串），键的顺序不限，未知的键被跳过；遇到子集以外的写法即失败
  */
-std::vector<Operation> read_enemy_operations() {
-    static std::vector<Operation> operations;
-    static std::vector<int> params;
-    int param, op_type;
+class Init_map_parser {
+public:
+    explicit Init_map_parser(std::string_view text) noexcept : ptr(text.data()), end(text.data() + text.size()) {}
 
-    operations.clear();
-    while (true) {
-        std::string line;
-        std::getline(std::cin, line);
-        std::stringstream ss(line);
-
-        // 读取操作类型
-        ss >> op_type;
-        // 操作结束
-        if (op_type == 8) break;
-
-        // 读取参数
-        while (true) {
-            ss >> param;
-            if (ss.fail()) break;
-            params.push_back(param);
+    /**
+     * @brief 解析至新构造的`gamestate`，语义与`parse_init_map_dom`相同
+     * @return 是否成功；失败时`gamestate`可能已被部分改写
+     */
+    bool parse(GameState& gamestate, int& seat) noexcept {
+        static constexpr int CELLS = Constant::col * Constant::row;
+        // `Cells`中第i项的格子，`Cell_type`的第i个字符是其地形
+        static Coord order[CELLS];
+        int cell_count = 0;
+        std::string_view types;
+        bool has_seat = false, has_cells = false, has_types = false, has_generals = false, has_coins = false;
+
+        auto parse_cell = [&]() {
+            int x, y, player, army;
+            if (cell_count == CELLS) return false;
+            if (!(expect('[') && expect('[') && integer(x) && expect(',') && integer(y) && expect(']') &&
+                  expect(',') && integer(player) && expect(',') && integer(army) && expect(']'))) return false;
+            Coord pos(x, y);
+            if (!pos.in_map()) return false;
+            Cell& cell = gamestate[pos];
+            cell.player = player;
+            cell.army = army;
+            cell.position = pos;
+            order[cell_count++] = pos;
+            return true;
+        };
+        auto parse_general = [&]() {
+            int id, player, type, x, y;
+            bool has_id = false, has_player = false, has_type = false, has_position = false;
+            bool ok = object([&](std::string_view key) {
+                if (key == "Id") return has_id = integer(id);
+                if (key == "Player") return has_player = integer(player);
+                if (key == "Type") return has_type = integer(type);
+                if (key == "Position") return has_position = expect('[') && integer(x) && expect(',') && integer(y) && expect(']');
+                return skip_value();
+            });
+            // `Type`字段为1~3，依次对应主将、副将与油井
+            if (!(ok && has_id && has_player && has_type && has_position) || type < 1 || type > 3) return false;
+            Coord pos(x, y);
+            if (!pos.in_map() || gamestate.generals.size() == MAX_GENERALS) return false;
+            gamestate.next_generals_id++;
+            gamestate[pos].general_slot = gamestate.generals.emplace(GeneralType(type - 1), id, player, pos);
+            return true;
+        };
+
+        bool ok = object([&](std::string_view key) {
+            if (key == "Player") return has_seat = integer(seat);
+            if (key == "Cell_type") return has_types = string(types);
+            if (key == "Cells") return has_cells = array(parse_cell);
+            if (key == "Generals") return has_generals = array(parse_general);
+            if (key == "Coins") {
+                int i = 0;
+                return has_coins = array([&]() { return i < PLAYER_COUNT && integer(gamestate.coin[i++]); });
+            }
+            return skip_value();
+        });
+        skip_space();
+        if (!(ok && ptr == end && has_seat && has_cells && has_types && has_generals && has_coins)) return false;
+        if (int(types.size()) < cell_count) return false;
+
+        for (int i = 0; i < cell_count; ++i) gamestate[order[i]].type = CellType(types[i] - '0');
+        // 以上直接改写了状态，需重建派生数据
+        gamestate.rebuild_derived();
+        return true;
+    }
+
+private:
+    const char* ptr;
+    const char* const end;
+
+    void skip_space() noexcept {
+        while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')) ++ptr;
+    }
+    // 跳过空白后若下一字符为`c`则读入之
+    bool expect(char c) noexcept {
+        skip_space();
+        if (ptr == end || *ptr != c) return false;
+        ++ptr;
+        return true;
+    }
+    bool integer(int& value) noexcept {
+        skip_space();
+        std::from_chars_result result = std::from_chars(ptr, end, value);
+        ptr = result.ptr;
+        return result.ec == std::errc();
+    }
+    bool string(std::string_view& value) noexcept {
+        if (!expect('"')) return false;
+        const char* close = static_cast<const char*>(std::memchr(ptr, '"', end - ptr));
+        if (!close || std::memchr(ptr, '\\', close - ptr)) return false;
+        value = std::string_view(ptr, close - ptr);
+        ptr = close + 1;
+        return true;
+    }
+    // 依次以`element()`读取数组的各元素
+    template <typename Func>
+    bool array(Func element) noexcept {
+        if (!expect('[')) return false;
+        if (expect(']')) return true;
+        do if (!element()) return false; while (expect(','));
+        return expect(']');
+    }
+    // 依次以`member(key)`读取对象的各成员值
+    template <typename Func>
+    bool object(Func member) noexcept {
+        if (!expect('{')) return false;
+        if (expect('}')) return true;
+        std::string_view key;
+        do if (!string(key) || !expect(':') || !member(key)) return false; while (expect(','));
+        return expect('}');
+    }
+    bool skip_value() noexcept {
+        skip_space();
+        if (ptr == end) return false;
+        std::string_view ignored;
+        switch (*ptr) {
+            case '{': return object([&](std::string_view) { return skip_value(); });
+            case '[': return array([&]() { return skip_value(); });
+            case '"': return string(ignored);
+        }
+        // 数字与true/false/null
+        const char* start = ptr;
+        while (ptr < end && (std::isalnum(static_cast<unsigned char>(*ptr)) || *ptr == '-' || *ptr == '+' || *ptr == '.')) ++ptr;
+        return ptr > start;
+    }
+};
+
+/**
+ * @brief 解析初始地图及先后手信息
+ * @param s 评测机发送的初始化行（JSON）
+ * @return int 先后手编号
+ * @note 先以`Init_map_parser`单遍解析，输入超出其支持的范围时清空状态并退回JSON DOM解析
+ */
+int parse_init_map(GameState& gamestate, std::string_view s) {
+    int seat;
+    if (Init_map_parser(s).parse(gamestate, seat)) return seat;
+    static const GameState blank;
+    gamestate.copy_as(blank);
+    return parse_init_map_dom(gamestate, s);
+}
+
+// 操作消息中表示本回合操作结束的行
+constexpr int OPERATION_END = 8;
+
+// 从文件描述符按行读取，返回的行直接指向内部缓冲区；除超长行导致的扩容外不分配内存
+class Line_reader {
+public:
+    explicit Line_reader(int fd, size_t capacity = 1 << 16) : fd(fd), buffer(capacity), begin(0), end(0) {}
+
+    /**
+     * @brief 读取下一行，不含换行符与行尾的`\r`
+     * @return 是否读到；输入已结束且没有剩余内容时返回false
+     * @note `line`在下次调用前有效
+     */
+    bool next_line(std::string_view& line) {
+        for (size_t scanned = begin; ; ) {
+            const char* newline = static_cast<const char*>(std::memchr(buffer.data() + scanned, '\n', end - scanned));
+            if (newline) return take(newline - buffer.data(), 1, line);
+
+            // 将不完整的行移至缓冲区开头，缓冲区已满时扩容
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            scanned = end;
+            if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+
+            ssize_t count = read(fd, buffer.data() + end, buffer.size() - end);
+            if (count < 0 && errno == EINTR) continue;
+            // 输入结束，最后一行可能没有换行符
+            if (count <= 0) return begin < end && take(end, 0, line);
+            end += count;
         }
-        operations.emplace_back(static_cast<OperationType>(op_type), params);
-        params.clear(); // 原本的代码并未进行此重置
     }
-    return operations;
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    // 缓冲区中尚未读取的内容为[begin, end)
+    size_t begin, end;
+
+    // 取出[begin, line_end)作为一行，并跳过其后`skip`个字符
+    bool take(size_t line_end, size_t skip, std::string_view& line) noexcept {
+        line = std::string_view(buffer.data() + begin, line_end - begin);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        begin = line_end + skip;
+        return true;
+    }
+};
+// 评测机输入，所有对标准输入的读取均须经由此对象
+Line_reader judger_input(STDIN_FILENO);
+
+/**
+ * @brief 就地解析一行操作：操作码与至多5个参数，以空白分隔
+ * @return int 操作码，格式错误时为-1；操作码为`OPERATION_END`时`op`不被修改
+ */
+int parse_operation(std::string_view line, Operation& op) noexcept {
+    const char* ptr = line.data();
+    const char* const end = ptr + line.size();
+    auto next_int = [&](int& value) {
+        while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r')) ++ptr;
+        std::from_chars_result result = std::from_chars(ptr, end, value);
+        ptr = result.ptr;
+        return result.ec == std::errc();
+    };
+    auto at_end = [&]() {
+        while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r')) ++ptr;
+        return ptr == end;
+    };
+
+    int code;
+    if (!next_int(code)) return -1;
+    if (code == OPERATION_END) return at_end() ? code : -1;
+    if (code < OperationType::DEFAULT_OP || code > OperationType::CALL_GENERAL) return -1;
+
+    op = Operation();
+    op.opcode = OperationType(code);
+    while (!at_end()) {
+        if (op.operand_count == 5 || !next_int(op.operand[op.operand_count])) return -1;
+        ++op.operand_count;
+    }
+    return code;
 }
-inline void convert_to_big_endian(const void *src, std::size_t size, void *dest)
-{
-    for (std::size_t i = 0; i < size; ++i)
-        static_cast<char *>(dest)[size - i - 1] = static_cast<const char *>(src)[i];
+
+/**
+ * @brief 读取初始地图及先后手信息
+ * @return int 先后手编号
+ */
+int read_init_map(GameState& gamestate) {
+    std::string_view line;
+    if (!judger_input.next_line(line)) throw std::runtime_error("Unexpected end of input");
+    return parse_init_map(gamestate, line);
 }
-inline void print_header(int size)
-{
-    // 按照judger要求发送消息长度
-    char buf[4] = {};
-    convert_to_big_endian(&size, sizeof(size), buf);
-    for (int i = 0; i < 4; ++i)
-        std::cout << buf[i];
+/**
+ * @brief 读取敌方操作列表至`operations`，直至`OPERATION_END`行
+ * @note 复用`operations`的容量，读取过程不分配内存
+ */
+void read_enemy_operations(std::vector<Operation>& operations) {
+    operations.clear();
+    std::string_view line;
+    Operation op;
+    while (true) {
+        if (!judger_input.next_line(line)) throw std::runtime_error("Unexpected end of input");
+        if (line.empty()) continue;
+
+        int code = parse_operation(line, op);
+        if (code < 0) throw std::runtime_error("Malformed operation: " + std::string(line));
+        if (code == OPERATION_END) return;
+        operations.push_back(op);
+    }
 }
+/**
+ * @brief 发往评测机的消息缓冲：长度头与内容直接格式化至预分配的缓冲区，以一次`write`发出
+ * @note 消息格式为4字节大端序长度头加消息内容；除超长消息导致的扩容外不分配内存
+ */
+class Message_writer {
+public:
+    explicit Message_writer(int fd, size_t capacity = 1 << 16) : fd(fd), buffer(capacity), size(HEADER_SIZE) {}
+
+    // 追加一个操作行，格式与`Operation::stringize`相同
+    void append(const Operation& op) {
+        reserve(MAX_OPERATION_LINE);
+        put_int(static_cast<int>(op.opcode));
+        for (int i = 0; i < op.operand_count; ++i) put_int(op.operand[i]);
+        buffer[size++] = '\n';
+    }
+    // 追加任意内容
+    void append(std::string_view text) {
+        reserve(text.size());
+        std::memcpy(buffer.data() + size, text.data(), text.size());
+        size += text.size();
+    }
+    // 补上长度头并发出当前消息，随后清空缓冲区
+    void send() {
+        uint32_t length = size - HEADER_SIZE;
+        for (size_t i = 0; i < HEADER_SIZE; ++i) buffer[i] = char(length >> (8 * (HEADER_SIZE - 1 - i)));
+        for (size_t written = 0; written < size; ) {
+            ssize_t count = write(fd, buffer.data() + written, size - written);
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0) throw std::runtime_error("Cannot write to judger");
+            written += count;
+        }
+        size = HEADER_SIZE;
+    }
+
+private:
+    static constexpr size_t HEADER_SIZE = 4;
+    // 操作行的最大长度：操作码与至多5个参数，各自至多11个字符并跟一个空格
+    static constexpr size_t MAX_OPERATION_LINE = 6 * 12 + 1;
+
+    int fd;
+    std::vector<char> buffer;
+    // 已写入的长度，含预留的长度头
+    size_t size;
+
+    void reserve(size_t extra) {
+        if (size + extra > buffer.size()) buffer.resize(std::max(buffer.size() * 2, size + extra));
+    }
+    void put_int(int value) noexcept {
+        size = std::to_chars(buffer.data() + size, buffer.data() + buffer.size(), value).ptr - buffer.data();
+        buffer[size++] = ' ';
+    }
+};
+// 发往评测机的输出，所有对标准输出的写入均须经由此对象
+Message_writer judger_output(STDOUT_FILENO);
 
 /**
  * @brief 向评测机发送一个字符串
  * @param msg string
  */
-void write_to_judger(const std::string &msg)
-{
-    // 先发送消息长度，再发送消息本身
-    print_header(msg.length());
-    std::cout << msg;
+void write_to_judger(std::string_view msg) {
+    judger_output.append(msg);
+    judger_output.send();
 }
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "json.hpp"
+#include "operation.hpp"
+#include "gamestate.hpp"
+#include "protocol.hpp"
+#include "util.hpp"
+#include "replay.hpp"
+#include "test_sync.hpp"
+
+// 录像中的一个操作
+struct Recorded_action {
+    int player;
+    Operation op;
+};
+
+// 录像中的一个回合：按执行顺序排列的双方操作，以及回合结束时录像所记录的局面
+struct Recorded_round {
+    std::vector<Recorded_action> actions;
+    // 是否经过回合结算，对局在回合中途结束时为false
+    bool settled;
+    // 各格的归属与兵力，按`x * row + y`排列
+    std::vector<int> player, army;
+    // 双方金币，录像未记录时为-1
+    int coin[PLAYER_COUNT];
+    // 完整局面的哈希值，仅在`has_zobrist`时有效
+    bool has_zobrist;
+    uint64_t zobrist;
+};
+
+// 一局录像：初始局面与各回合
+struct Recorded_match {
+    std::string path;
+    GameState initial;
+    std::vector<Recorded_round> rounds;
+    int action_count;
+};
+
+/**
+ * @brief 读取一局录像至`match`
+ * @note 以`Replay_header::MAGIC`开头的文件按本地回放格式读取，关键帧处另记录金币与完整局面哈希
+ * @note 否则按评测平台下载的`replay.json`读取：每行一个JSON，首行为初始局面，其后每行为一个操作或系统事件
+ *       （`Action`首项1~7为操作，8为回合结算，9为对局结束），`Cells`为该事件后变化的格子
+ */
+void load_recorded_match(const std::string& path, Recorded_match& match) {
+    static const GameState blank;
+    match.path = path;
+    match.initial.copy_as(blank);
+    match.rounds.clear();
+    match.action_count = 0;
+
+    const int cells = Constant::col * Constant::row;
+    std::vector<int> player(cells), army(cells);
+    auto begin_round = [&]() -> Recorded_round& {
+        match.rounds.emplace_back();
+        Recorded_round& round = match.rounds.back();
+        round.settled = true;
+        round.coin[0] = round.coin[1] = -1;
+        round.has_zobrist = false;
+        return round;
+    };
+    auto end_round = [&](Recorded_round& round) {
+        round.player = player;
+        round.army = army;
+        match.action_count += round.actions.size();
+    };
+
+    Mapped_file file(path);
+    if (file.length() >= sizeof(Replay_header) && std::memcmp(file.data(), Replay_header::MAGIC, sizeof(Replay_header::MAGIC)) == 0) {
+        Replay_view replay(file.data(), file.length());
+        replay.read_map(match.initial);
+        for (int i = 0; i < cells; ++i) {
+            player[i] = match.initial.board[i / Constant::row][i % Constant::row].player;
+            army[i] = match.initial.board[i / Constant::row][i % Constant::row].army;
+        }
+
+        Replay_round record;
+        GameState keyframe;
+        const int interval = replay.info().keyframe_interval;
+        for (int r = 1; r <= replay.round_count(); ++r) {
+            replay.read_round(r, record);
+            Recorded_round& round = begin_round();
+            for (int p = 0; p < PLAYER_COUNT; ++p) for (const Operation& op : record.ops[p]) round.actions.push_back({p, op});
+            for (const Replay_round::Cell_change& change : record.changes) {
+                int i = change.pos.x * Constant::row + change.pos.y;
+                player[i] = change.player;
+                army[i] += change.army_delta;
+            }
+            round.settled = r < replay.round_count() || !(replay.info().flags & Replay_header::LAST_ROUND_UNSETTLED);
+            if (round.settled && r % interval == 0 && r / interval < replay.keyframe_count()) {
+                keyframe.copy_as(blank);
+                replay.read_keyframe(r / interval, keyframe);
+                round.coin[0] = keyframe.coin[0], round.coin[1] = keyframe.coin[1];
+                round.has_zobrist = true;
+                round.zobrist = keyframe.zobrist;
+            }
+            end_round(round);
+        }
+        return;
+    }
+
+    std::ifstream in(path);
+    std::string line;
+    bool first = true;
+    Recorded_round* round = nullptr;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (first) {
+            parse_init_map(match.initial, line);
+            for (int i = 0; i < cells; ++i) {
+                player[i] = match.initial.board[i / Constant::row][i % Constant::row].player;
+                army[i] = match.initial.board[i / Constant::row][i % Constant::row].army;
+            }
+            first = false;
+            continue;
+        }
+
+        auto d = nlohmann::json::parse(line);
+        for (const auto& cell : d["Cells"]) {
+            int x = cell[0][0], y = cell[0][1];
+            Coord pos(x, y);
+            if (!pos.in_map()) throw std::runtime_error("Cell out of range in " + path);
+            player[pos.x * Constant::row + pos.y] = int(cell[1]);
+            army[pos.x * Constant::row + pos.y] = int(cell[2]);
+        }
+
+        const auto& action = d["Action"];
+        int code = int(action[0]);
+        if (code == 9) break;
+        if (!round) round = &begin_round();
+        if (code == 8) {
+            round->coin[0] = int(d["Coins"][0]), round->coin[1] = int(d["Coins"][1]);
+            end_round(*round);
+            round = nullptr;
+            continue;
+        }
+
+        std::vector<int> params;
+        for (size_t i = 1; i < action.size(); ++i) params.push_back(int(action[i]));
+        if (code < 1 || code > 7 || params.size() > 5) throw std::runtime_error("Unknown action in " + path);
+        round->actions.push_back({int(d["Player"]), Operation(static_cast<OperationType>(code), params)});
+    }
+    if (first) throw std::runtime_error("Empty replay " + path);
+    // 对局在回合中途结束
+    if (round) {
+        round->settled = false;
+        end_round(*round);
+    }
+}
+
+// `path`下的全部录像（.rpl与.json文件），目录递归查找，按路径排序
+std::vector<std::string> find_recorded_matches(const std::string& path) {
+    std::vector<std::string> ret;
+    struct stat st;
+    if (stat(path.c_str(), &st)) throw std::runtime_error("Cannot open " + path);
+    if (!S_ISDIR(st.st_mode)) {
+        ret.push_back(path);
+        return ret;
+    }
+
+    DIR* handle = opendir(path.c_str());
+    if (!handle) throw std::runtime_error("Cannot open " + path);
+    std::vector<std::string> entries;
+    while (const dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") entries.push_back(path + "/" + name);
+    }
+    closedir(handle);
+
+    auto has_suffix = [](const std::string& s, const char* suffix) {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    };
+    for (const std::string& entry : entries) {
+        if (stat(entry.c_str(), &st)) continue;
+        if (S_ISDIR(st.st_mode)) {
+            std::vector<std::string> sub = find_recorded_matches(entry);
+            ret.insert(ret.end(), sub.begin(), sub.end());
+        }
+        else if (has_suffix(entry, ".rpl") || has_suffix(entry, ".json")) ret.push_back(entry);
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+// 重演中首个与录像不符之处
+struct Divergence {
+    // 所在回合（从1开始）
+    int round;
+    // 被引擎拒绝的操作在本回合中的序号，回合结束后的比较不符时为-1
+    int action;
+    std::string reason;
+};
+
+/**
+ * @brief 在`state`上逐回合重演`match`，每回合结束后与录像记录的局面比较
+ * @return 是否与录像完全一致；不一致时写入`divergence`，`state`停留在分歧处
+ */
+bool verify_match(const Recorded_match& match, GameState& state, Divergence& divergence) {
+    state.copy_as(match.initial);
+    for (int r = 0; r < int(match.rounds.size()); ++r) {
+        const Recorded_round& round = match.rounds[r];
+        divergence.round = r + 1;
+        for (int i = 0; i < int(round.actions.size()); ++i) {
+            const Recorded_action& action = round.actions[i];
+            if (execute_operation(state, action.player, action.op, false)) continue;
+            divergence.action = i;
+            divergence.reason = wrap("player %d: operation rejected: %s", action.player, action.op.str().c_str());
+            return false;
+        }
+        if (round.settled) state.update_round();
+
+        divergence.action = -1;
+        for (int i = 0; i < Constant::col * Constant::row; ++i) {
+            const Cell& cell = state.board[i / Constant::row][i % Constant::row];
+            if (cell.player == round.player[i] && cell.army == round.army[i]) continue;
+            divergence.reason = wrap("cell %s: player %d army %d, expected player %d army %d", cell.position.str().c_str(),
+                                     int(cell.player), cell.army, round.player[i], round.army[i]);
+            return false;
+        }
+        for (int p = 0; p < PLAYER_COUNT; ++p) {
+            if (round.coin[p] < 0 || state.coin[p] == round.coin[p]) continue;
+            divergence.reason = wrap("player %d: coin %d, expected %d", p, state.coin[p], round.coin[p]);
+            return false;
+        }
+        if (round.has_zobrist && state.zobrist != round.zobrist) {
+            divergence.reason = "full state hash differs from keyframe";
+            return false;
+        }
+    }
+    return true;
+}
+
+// 输出分歧处的实际局面（`show_map`格式）与录像记录的兵力分布，不符的格子以`*`标出
+void show_divergence(const Recorded_match& match, const GameState& state, const Divergence& divergence, std::ostream& f) {
+    f << match.path << ": round " << divergence.round;
+    if (divergence.action >= 0) f << " action " << divergence.action;
+    f << ": " << divergence.reason << "\n\nactual:\n";
+    show_map(state, f);
+
+    const Recorded_round& round = match.rounds[divergence.round - 1];
+    f << "expected:\n";
+    for (int y = Constant::row - 1; y >= 0; --y) {
+        for (int x = 0; x < Constant::col; ++x) {
+            int i = x * Constant::row + y;
+            const Cell& cell = state.board[x][y];
+            bool differs = cell.player != round.player[i] || cell.army != round.army[i];
+            f << wrap("%c%2d%c", round.player[i] == 1 ? '-' : ' ', round.army[i], differs ? '*' : ' ');
+        }
+        f << "\n";
+    }
+    f << '\n';
+}
+
+/**
+ * @brief 以`execute_operation`与`update_round`重演`match`一遍，不做任何比较
+ * @return 耗时（秒），不含复制初始局面
+ */
+double time_match(const Recorded_match& match, GameState& state) {
+    state.copy_as(match.initial);
+    auto start = std::chrono::steady_clock::now();
+    for (const Recorded_round& round : match.rounds) {
+        for (const Recorded_action& action : round.actions) execute_operation(state, action.player, action.op, false);
+        if (round.settled) state.update_round();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,536 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "operation.hpp"
+#include "gamestate.hpp"
+#include "binary.hpp"
+#include "mapgen.hpp"
+#include "util.hpp"
+
+/**
+ * 二进制回放格式（小端序）：
+ *   Replay_header   定长文件头
+ *   初始地图         `encode_map`的输出
+ *   回合记录与关键帧  按回合顺序排列，关键帧位于其所在回合的记录之前
+ *   索引表           `round_count`个回合记录偏移与`keyframe_count`个关键帧偏移，均为uint64
+ * 回合记录：双方依次为操作数与各操作，随后是本回合（含结算）变化的格子（下标差分、归属、兵力差）
+ * 第k个关键帧为第`1 + k * keyframe_interval`回合开始前的完整局面
+ * 借助文件头与索引表，mmap后可直接定位任一回合或关键帧，无需解析整个文件
+ */
+struct Replay_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t keyframe_interval;
+    uint32_t round_count;
+    uint32_t keyframe_count;
+    int32_t winner;
+    uint32_t flags;
+    uint64_t index_offset;
+
+    static constexpr char MAGIC[4] = {'G', 'R', 'P', 'L'};
+    static constexpr uint16_t VERSION = 1;
+    // 最后一回合未经结算（对局在回合中途结束）
+    static constexpr uint32_t LAST_ROUND_UNSETTLED = 1;
+};
+static_assert(sizeof(Replay_header) == 32, "Replay_header layout changed");
+
+// 单个操作：首字节为操作码（低4位）与参数个数（高4位），其后为各参数
+void encode_operation(const Operation& op, Byte_writer& out) {
+    out.u8(static_cast<int>(op.opcode) | op.operand_count << 4);
+    for (int i = 0; i < op.operand_count; ++i) out.svarint(op.operand[i]);
+}
+Operation decode_operation(Byte_reader& in) {
+    Operation op;
+    uint8_t tag = in.u8();
+    op.opcode = OperationType(tag & 15);
+    op.operand_count = tag >> 4;
+    if (op.operand_count > 5) throw std::runtime_error("Too many operands");
+    for (int i = 0; i < op.operand_count; ++i) op.operand[i] = int(in.svarint());
+    return op;
+}
+
+/**
+ * @brief 完整局面的紧凑编码，用作关键帧
+ * @note 只记录参与哈希的基本状态，派生数据在读取时由`rebuild_derived`重建；将领按槽位顺序记录，以保持槽位编号不变
+ */
+void encode_state(const GameState& state, Byte_writer& out) {
+    out.varint(state.round);
+    out.varint(state.next_generals_id);
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        out.svarint(state.coin[p]);
+        out.u8(state.super_weapon_unlocked[p]);
+        out.svarint(state.super_weapon_cd[p]);
+        out.svarint(state.rest_move_step[p]);
+        for (int level : state.tech_level[p]) out.svarint(level);
+    }
+
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        const Cell& cell = state.board[x][y];
+        out.u8(static_cast<int>(cell.type) | (cell.player + 1) << 2);
+        out.varint(cell.army);
+    }
+
+    out.varint(state.generals.size());
+    for (int slot = 0; slot < state.generals.size(); ++slot) {
+        const Generals& general = *state.generals[slot];
+        out.u8(static_cast<int>(general.type) | general.alive << 2);
+        out.varint(general.id);
+        out.svarint(general.player);
+        out.u8(general.position.x);
+        out.u8(general.position.y);
+        out.varint(general.produce_level);
+        out.bytes(&general.defence_level, sizeof(double));
+        out.varint(general.mobility_level);
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) {
+            out.svarint(general.skills_cd[i]);
+            out.svarint(general.skill_duration[i]);
+        }
+        out.svarint(general.rest_move);
+    }
+
+    out.varint(state.active_super_weapon.size());
+    for (const SuperWeapon& weapon : state.active_super_weapon) {
+        out.u8(static_cast<int>(weapon.type));
+        out.svarint(weapon.player);
+        out.svarint(weapon.cd);
+        out.svarint(weapon.rest);
+        out.u8(weapon.position.x);
+        out.u8(weapon.position.y);
+    }
+}
+// 读取`encode_state`的输出，写入新构造的`state`
+void decode_state(GameState& state, Byte_reader& in) {
+    state.round = int(in.varint());
+    state.next_generals_id = int(in.varint());
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        state.coin[p] = int(in.svarint());
+        state.super_weapon_unlocked[p] = in.u8();
+        state.super_weapon_cd[p] = int(in.svarint());
+        state.rest_move_step[p] = int(in.svarint());
+        for (int& level : state.tech_level[p]) level = int(in.svarint());
+    }
+
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        Cell& cell = state.board[x][y];
+        uint8_t tag = in.u8();
+        cell.type = CellType(tag & 3);
+        cell.player = int(tag >> 2) - 1;
+        cell.army = int(in.varint());
+        cell.general_slot = -1;
+        cell.position = Coord(x, y);
+    }
+
+    int count = int(in.varint());
+    if (count > MAX_GENERALS) throw std::runtime_error("Too many generals");
+    for (int slot = 0; slot < count; ++slot) {
+        uint8_t tag = in.u8();
+        int id = int(in.varint());
+        int player = int(in.svarint());
+        int x = in.u8(), y = in.u8();
+        if (!Coord(x, y).in_map()) throw std::runtime_error("General position out of range");
+        Generals& general = *state.generals[state.generals.emplace(GeneralType(tag & 3), id, player, Coord(x, y))];
+        general.alive = tag >> 2;
+        general.produce_level = int(in.varint());
+        in.bytes(&general.defence_level, sizeof(double));
+        general.mobility_level = int(in.varint());
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) {
+            general.skills_cd[i] = int(in.svarint());
+            general.skill_duration[i] = int(in.svarint());
+        }
+        general.rest_move = int(in.svarint());
+        if (general.alive) state[general.position].general_slot = slot;
+    }
+
+    state.active_super_weapon.clear();
+    for (int count = int(in.varint()); count > 0; --count) {
+        SuperWeapon weapon;
+        weapon.type = WeaponType(in.u8());
+        weapon.player = int(in.svarint());
+        weapon.cd = int(in.svarint());
+        weapon.rest = int(in.svarint());
+        int x = in.u8(), y = in.u8();
+        weapon.position = Coord(x, y);
+        state.active_super_weapon.push_back(weapon);
+    }
+    // 以上直接改写了状态，需重建派生数据
+    state.rebuild_derived();
+}
+
+// 回放写入器：逐回合追加记录，结束时补上文件头与索引表
+class Replay_writer {
+public:
+    explicit Replay_writer(const GameState& initial, int keyframe_interval = 50) : keyframe_interval(keyframe_interval) {
+        assert(keyframe_interval > 0);
+        out.data.resize(sizeof(Replay_header));
+        encode_map(initial, out);
+        for (int i = 0; i < Constant::col * Constant::row; ++i) {
+            last_player[i] = initial.board[i / Constant::row][i % Constant::row].player;
+            last_army[i] = initial.board[i / Constant::row][i % Constant::row].army;
+        }
+        keyframe_offsets.push_back(out.data.size());
+        encode_state(initial, out);
+    }
+
+    /**
+     * @brief 追加一个回合
+     * @param after 本回合（含结算）结束后的局面，需要时作为下一回合的关键帧
+     * @note 对局结束后多出的关键帧不会被读取
+     */
+    void add_round(const Operation* ops0, int count0, const Operation* ops1, int count1, const GameState& after) {
+        round_offsets.push_back(out.data.size());
+        out.varint(count0);
+        for (int i = 0; i < count0; ++i) encode_operation(ops0[i], out);
+        out.varint(count1);
+        for (int i = 0; i < count1; ++i) encode_operation(ops1[i], out);
+
+        changed.clear();
+        for (int i = 0; i < Constant::col * Constant::row; ++i) {
+            const Cell& cell = after.board[i / Constant::row][i % Constant::row];
+            if (cell.player != last_player[i] || cell.army != last_army[i]) changed.push_back(i);
+        }
+        out.varint(changed.size());
+        int last = 0;
+        for (int i : changed) {
+            const Cell& cell = after.board[i / Constant::row][i % Constant::row];
+            out.varint(i - last);
+            out.u8(cell.player + 1);
+            out.svarint(cell.army - last_army[i]);
+            last_player[i] = cell.player;
+            last_army[i] = cell.army;
+            last = i;
+        }
+
+        if (round_offsets.size() % keyframe_interval == 0) {
+            keyframe_offsets.push_back(out.data.size());
+            encode_state(after, out);
+        }
+    }
+
+    // 写入文件头与索引表，返回完整的回放数据；`last_round_unsettled`表示对局在最后一回合中途结束
+    const std::string& finish(int winner, bool last_round_unsettled) {
+        Replay_header header;
+        std::memcpy(header.magic, Replay_header::MAGIC, sizeof(header.magic));
+        header.version = Replay_header::VERSION;
+        header.keyframe_interval = keyframe_interval;
+        header.round_count = round_offsets.size();
+        header.keyframe_count = keyframe_offsets.size();
+        header.winner = winner;
+        header.flags = last_round_unsettled ? Replay_header::LAST_ROUND_UNSETTLED : 0;
+        header.index_offset = out.data.size();
+        out.bytes(round_offsets.data(), round_offsets.size() * sizeof(uint64_t));
+        out.bytes(keyframe_offsets.data(), keyframe_offsets.size() * sizeof(uint64_t));
+        std::memcpy(out.data.data(), &header, sizeof(header));
+        return out.data;
+    }
+
+private:
+    int keyframe_interval;
+    Byte_writer out;
+    std::vector<uint64_t> round_offsets, keyframe_offsets;
+    // 上一回合结束时各格的归属与兵力，按`x * row + y`排列
+    int last_player[Constant::col * Constant::row];
+    int last_army[Constant::col * Constant::row];
+    // 本回合变化的格子下标，跨回合复用
+    std::vector<int> changed;
+};
+
+// 一个回合的记录，跨回合复用时不再重新分配
+struct Replay_round {
+    // 双方操作
+    std::vector<Operation> ops[PLAYER_COUNT];
+    // 变化的格子：坐标、新归属与兵力变化量
+    struct Cell_change { Coord pos; int player; int army_delta; };
+    std::vector<Cell_change> changes;
+};
+
+// 只读映射的文件，析构时解除映射
+class Mapped_file {
+public:
+    explicit Mapped_file(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st)) {
+            close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        size = st.st_size;
+        ptr = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (ptr == MAP_FAILED) throw std::runtime_error("Cannot mmap " + path);
+    }
+    Mapped_file(const Mapped_file&) = delete;
+    Mapped_file& operator=(const Mapped_file&) = delete;
+    ~Mapped_file() noexcept { if (ptr) munmap(ptr, size); }
+
+    const char* data() const noexcept { return static_cast<const char*>(ptr); }
+    size_t length() const noexcept { return size; }
+
+private:
+    void* ptr;
+    size_t size;
+};
+
+// 回放数据的只读视图，不持有数据；各部分按需解码
+class Replay_view {
+public:
+    Replay_view(const char* data, size_t size) : data(data), size(size) {
+        if (size < sizeof(Replay_header)) throw std::runtime_error("Replay too short");
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, Replay_header::MAGIC, sizeof(header.magic)) || header.version != Replay_header::VERSION)
+            throw std::runtime_error("Not a replay file");
+        uint64_t index_size = (uint64_t(header.round_count) + header.keyframe_count) * sizeof(uint64_t);
+        if (header.index_offset > size || size - header.index_offset < index_size) throw std::runtime_error("Replay index out of range");
+    }
+
+    const Replay_header& info() const noexcept { return header; }
+    int round_count() const noexcept { return header.round_count; }
+    int keyframe_count() const noexcept { return header.keyframe_count; }
+    // 第`keyframe`个关键帧所在的回合，可能超出`round_count`
+    int keyframe_round(int keyframe) const noexcept { return 1 + keyframe * header.keyframe_interval; }
+
+    // 读取初始地图至新构造的`state`
+    void read_map(GameState& state) const {
+        Byte_reader in(data + sizeof(Replay_header), header.index_offset - sizeof(Replay_header));
+        decode_map(state, in);
+    }
+    // 读取第`keyframe`个关键帧至新构造的`state`
+    void read_keyframe(int keyframe, GameState& state) const {
+        assert(keyframe >= 0 && keyframe < keyframe_count());
+        Byte_reader in = reader_at(offset_at(header.round_count + keyframe));
+        decode_state(state, in);
+    }
+    // 读取第`round`回合（从1开始）的记录
+    void read_round(int round, Replay_round& record) const {
+        assert(round >= 1 && round <= round_count());
+        Byte_reader in = reader_at(offset_at(round - 1));
+        for (std::vector<Operation>& ops : record.ops) {
+            ops.clear();
+            for (uint64_t count = in.varint(); count > 0; --count) ops.push_back(decode_operation(in));
+        }
+        record.changes.clear();
+        int cell = 0;
+        for (uint64_t count = in.varint(); count > 0; --count) {
+            cell += int(in.varint());
+            if (cell >= Constant::col * Constant::row) throw std::runtime_error("Cell index out of range");
+            int player = int(in.u8()) - 1;
+            int delta = int(in.svarint());
+            record.changes.push_back({Coord(cell / Constant::row, cell % Constant::row), player, delta});
+        }
+    }
+
+private:
+    const char* data;
+    size_t size;
+    Replay_header header;
+
+    uint64_t offset_at(int index) const noexcept {
+        uint64_t offset;
+        std::memcpy(&offset, data + header.index_offset + index * sizeof(uint64_t), sizeof(offset));
+        return offset;
+    }
+    Byte_reader reader_at(uint64_t offset) const {
+        if (offset < sizeof(Replay_header) || offset >= header.index_offset) throw std::runtime_error("Replay offset out of range");
+        return Byte_reader(data + offset, header.index_offset - offset);
+    }
+};
+
+// 将`finish`返回的回放数据写入文件
+void save_replay(const std::string& path, const std::string& data) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    bool ok = file && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (file) ok = std::fclose(file) == 0 && ok;
+    if (!ok) throw std::runtime_error("Cannot write " + path);
+}
+
+/**
+ * @brief 回放的随机访问读取器：从最近的关键帧出发重演，得到任一回合任一操作处的精确局面
+ * @note 位置(round, action)指第`round`回合已依次执行前`action`个操作（先0号玩家后1号玩家）、尚未结算时的局面；
+ *       `action`等于本回合操作总数时为结算前的局面，最后一回合已结算时(round_count + 1, 0)为终局
+ * @note 定位一次至多重演`keyframe_interval()`个回合的操作与结算
+ */
+class Replay_loader {
+public:
+    /**
+     * @brief 打开回放文件并定位至(1, 0)
+     * @param keyframe_interval 为正且小于文件中的关键帧间隔时，先完整重演一遍，在内存中按此间隔建立关键帧索引
+     */
+    explicit Replay_loader(const std::string& path, int keyframe_interval = 0) : file(path), replay(file.data(), file.length()) {
+        interval = replay.info().keyframe_interval;
+        keyframes = 0;
+        while (keyframes < replay.keyframe_count() && replay.keyframe_round(keyframes) <= last_round()) ++keyframes;
+        if (!keyframes) throw std::runtime_error("Replay has no keyframe");
+        load_keyframe(0);
+
+        if (keyframe_interval > 0 && keyframe_interval < interval) {
+            for (;;) {
+                if (cur_action == 0 && (cur_round - 1) % keyframe_interval == 0) {
+                    Byte_writer out;
+                    encode_state(game, out);
+                    built.push_back(std::move(out.data));
+                }
+                if (at_end()) break;
+                advance();
+            }
+            interval = keyframe_interval;
+            keyframes = built.size();
+            load_keyframe(0);
+        }
+    }
+    Replay_loader(const Replay_loader&) = delete;
+    Replay_loader& operator=(const Replay_loader&) = delete;
+
+    const Replay_view& view() const noexcept { return replay; }
+    // 当前局面
+    const GameState& state() const noexcept { return game; }
+    int round() const noexcept { return cur_round; }
+    int action() const noexcept { return cur_action; }
+    // 所用关键帧的间隔
+    int keyframe_interval() const noexcept { return interval; }
+    // 最后一个可定位的回合
+    int last_round() const noexcept {
+        bool settled = !(replay.info().flags & Replay_header::LAST_ROUND_UNSETTLED);
+        return std::max(1, replay.round_count() + settled);
+    }
+
+    // 当前回合的记录，终局时双方操作均为空
+    const Replay_round& record() const noexcept { return rec; }
+    // 当前回合的操作总数
+    int action_count() const noexcept { return int(rec.ops[0].size() + rec.ops[1].size()); }
+    // 当前回合第`index`个操作的执行方
+    int action_player(int index) const noexcept { return index < int(rec.ops[0].size()) ? 0 : 1; }
+    // 当前回合第`index`个操作
+    const Operation& action_at(int index) const noexcept {
+        assert(index >= 0 && index < action_count());
+        int first = rec.ops[0].size();
+        return index < first ? rec.ops[0][index] : rec.ops[1][index - first];
+    }
+
+    // 是否已位于回放末尾
+    bool at_end() const noexcept { return cur_round == last_round() && cur_action == action_count(); }
+
+    /**
+     * @brief 定位至(round, action)
+     * @note 目标在当前位置之后且不早于其所在区间的关键帧时直接向前重演，否则从该关键帧开始
+     */
+    void jump_to(int round, int action) {
+        if (round < 1 || round > last_round()) throw std::out_of_range("Replay round out of range");
+        int count = 0;
+        if (round <= replay.round_count()) {
+            replay.read_round(round, scratch);
+            count = int(scratch.ops[0].size() + scratch.ops[1].size());
+        }
+        if (action < 0 || action > count) throw std::out_of_range("Replay action out of range");
+
+        int keyframe = std::min((round - 1) / interval, keyframes - 1);
+        bool forward = round > cur_round || (round == cur_round && action >= cur_action);
+        if (!forward || cur_round < 1 + keyframe * interval) load_keyframe(keyframe);
+        while (cur_round < round || cur_action < action) advance();
+    }
+
+    // 前进一个操作，或在回合末进行结算；已位于末尾时返回false
+    bool next() {
+        if (at_end()) return false;
+        advance();
+        return true;
+    }
+
+private:
+    Mapped_file file;
+    Replay_view replay;
+    // 内存中建立的关键帧，为空时使用文件中的关键帧
+    std::vector<std::string> built;
+    int interval, keyframes;
+
+    GameState game;
+    int cur_round, cur_action;
+    Replay_round rec, scratch;
+
+    void load_keyframe(int keyframe) {
+        static const GameState blank;
+        game.copy_as(blank);
+        if (built.empty()) replay.read_keyframe(keyframe, game);
+        else {
+            Byte_reader in(built[keyframe].data(), built[keyframe].size());
+            decode_state(game, in);
+        }
+        cur_round = 1 + keyframe * interval;
+        cur_action = 0;
+        assert(game.round == cur_round);
+        load_record();
+    }
+    void load_record() {
+        if (cur_round <= replay.round_count()) replay.read_round(cur_round, rec);
+        else for (std::vector<Operation>& ops : rec.ops) ops.clear();
+    }
+    void advance() {
+        if (cur_action < action_count()) {
+            if (!execute_operation(game, action_player(cur_action), action_at(cur_action), false))
+                throw std::runtime_error(wrap("Replay diverged at round %d action %d", cur_round, cur_action));
+            ++cur_action;
+            return;
+        }
+        game.update_round();
+        ++cur_round;
+        cur_action = 0;
+        load_record();
+    }
+};
+
+// 目录中的全部回放文件（扩展名为.rpl），按文件名排序
+std::vector<std::string> list_replays(const std::string& dir) {
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) throw std::runtime_error("Cannot open " + dir);
+    std::vector<std::string> paths;
+    while (const dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".rpl") == 0) paths.push_back(dir + "/" + name);
+    }
+    closedir(handle);
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+/**
+ * @brief 依次打开多个回放，用于对大量对局做流式分析；同一时刻只映射一个文件
+ * @code
+ * Replay_stream stream(list_replays(dir));
+ * while (Replay_loader* replay = stream.next()) do { ... replay->state() ... } while (replay->next());
+ * @endcode
+ */
+class Replay_stream {
+public:
+    explicit Replay_stream(std::vector<std::string> paths, int keyframe_interval = 0) noexcept :
+        paths(std::move(paths)), keyframe_interval(keyframe_interval), index(0) {}
+
+    // 打开下一个回放并定位至开局，全部读完时返回nullptr；此前返回的读取器随之失效
+    Replay_loader* next() {
+        current.reset();
+        if (index >= paths.size()) return nullptr;
+        current = std::make_unique<Replay_loader>(paths[index++], keyframe_interval);
+        return current.get();
+    }
+    // 当前回放的路径
+    const std::string& path() const noexcept { return paths[index - 1]; }
+    int size() const noexcept { return paths.size(); }
+
+private:
+    std::vector<std::string> paths;
+    int keyframe_interval;
+    size_t index;
+    std::unique_ptr<Replay_loader> current;
+};
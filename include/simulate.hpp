@@ -0,0 +1,77 @@
+#pragma once
+
+#include "operation.hpp"
+#include "gamestate.hpp"
+#include "util.hpp"
+
+// 一方在一个回合内的操作序列，不持有内存
+struct Turn_ops {
+    const Operation* ops;
+    int count;
+    // 非空时逐个写入操作是否执行成功，长度至少为`count`
+    bool* valid;
+
+    Turn_ops() noexcept : ops(nullptr), count(0), valid(nullptr) {}
+    Turn_ops(const Operation* ops, int count, bool* valid = nullptr) noexcept : ops(ops), count(count), valid(valid) {}
+    Turn_ops(const Operation_list& list, bool* valid = nullptr) noexcept : ops(list.ops.data()), count(static_cast<int>(list.ops.size())), valid(valid) {}
+};
+
+// 一个回合的模拟结果
+struct Step_result {
+    // 各方成功执行的操作数
+    int valid_count[PLAYER_COUNT];
+    // 获胜方，尚未分出胜负时为-1
+    int winner;
+
+    bool finished() const noexcept { return winner >= 0; }
+};
+
+// 主将已被俘获的玩家，没有则返回-1
+int captured_player(const GameState& state) noexcept {
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        int slot = state.generals.main_general_slot(p);
+        if (slot >= 0 && state.generals[slot]->player != p) return p;
+    }
+    return -1;
+}
+
+/**
+ * @brief 操作能否安全地交给`execute_operation`：格式合法，且移动军队的目标格在地图内
+ * @note 引擎把这些条件视为调用者的前置条件，违反时断言失败而非返回false
+ */
+bool executable(const Operation& op) noexcept {
+    if (!op.well_formed()) return false;
+    if (op.opcode != OperationType::MOVE_ARMY) return true;
+    return (Coord(op.operand[0], op.operand[1]) + DIRECTION_ARR[op.operand[2] - 1]).in_map();
+}
+
+/**
+ * @brief 模拟完整的一个回合：按座次先后执行双方的操作，再进行回合结算
+ * @param ops0 先手（0号玩家）的操作
+ * @param ops1 后手（1号玩家）的操作
+ * @return Step_result 各方成功执行的操作数与胜负情况
+ * @note 失败的操作被跳过，后续操作照常执行；一方主将被俘时对局立即结束，剩余操作均记为失败且不进行回合结算
+ * @note 操作可以未经检查：不满足`executable`的操作不交给引擎执行，直接记为失败
+ * @note 整个过程不输出日志、不分配内存；`state`不得挂接撤销日志
+ */
+Step_result step(GameState& state, const Turn_ops& ops0, const Turn_ops& ops1) noexcept {
+    assert(state.journal == nullptr);
+    Step_result result{{0, 0}, -1};
+    const Turn_ops* sides[PLAYER_COUNT] = {&ops0, &ops1};
+
+    for (int p = 0; p < PLAYER_COUNT; ++p) {
+        const Turn_ops& side = *sides[p];
+        for (int i = 0; i < side.count; ++i) {
+            bool success = !result.finished() && executable(side.ops[i]) && execute_operation(state, p, side.ops[i], false);
+            if (side.valid) side.valid[i] = success;
+            if (!success) continue;
+
+            ++result.valid_count[p];
+            int loser = captured_player(state);
+            if (loser >= 0) result.winner = 1 - loser;
+        }
+    }
+
+    if (!result.finished()) state.update_round();
+    return result;
+}
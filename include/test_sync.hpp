@@ -1,8 +1,6 @@
 #pragma once
 #include <string>
 #include <fstream>
-#include <typeindex>
-#include <typeinfo>
 #include "gamestate.hpp"
 
 // This function shows the map of the game state and writes it to a file
@@ -26,11 +24,8 @@ void show_map(const GameState& state, std::ostream& f) {
         f << "\n";
     }
     for (const Generals* element : state.generals) {
-        char typenow = '?';
-        if (dynamic_cast<const MainGenerals*>(element)) typenow = 'M';
-        else if (dynamic_cast<const SubGenerals*>(element)) typenow = 'S';
-        else if (dynamic_cast<const OilWell*>(element)) typenow = 'O';
-        else assert(false);
+        static constexpr char type_char[] = {'M', 'S', 'O'};
+        char typenow = type_char[static_cast<int>(element->type)];
 
         f << "id: " << element->id << " ";
         f << "type: " << typenow << " ";
@@ -24,16 +24,15 @@ bool call_generals(GameState &gamestate, int player, const Coord& location) {
     // 如果棋盘上的位置不属于玩家，返回false
     if (cell.player != player) return false;
     // 如果棋盘上的位置已经有将军，返回false
-    else if (cell.generals != nullptr) return false;
-
-    // 创建一个新的将军
-    Generals *genPtr = new SubGenerals(gamestate.next_generals_id++, player, location);
-    // 将新的将军放置在棋盘上的指定位置
-    cell.generals = genPtr;
-    // 将新的将军添加到游戏状态的将军列表中
-    gamestate.generals.push_back(genPtr);
+    else if (cell.has_general()) return false;
+    // 如果将领池已满，返回false
+    if (gamestate.generals.full()) return false;
+
+    // 在将领池中创建一个新的将军，并将其槽位放置在棋盘上的指定位置
+    gamestate.set_cell_general(cell, gamestate.add_general(GeneralType::SUB_GENERAL, gamestate.next_generals_id, player, location));
+    gamestate.assign(gamestate.next_generals_id, gamestate.next_generals_id + 1);
     // 玩家的硬币减少50
-    gamestate.coin[player] -= Constant::SPAWN_GENERAL_COST;
+    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - Constant::SPAWN_GENERAL_COST);
     return true;
 }
 
@@ -49,8 +48,7 @@ bool call_generals(GameState &gamestate, int player, const Coord& location) {
 * 返回值：如果移动成功，返回 `true`；否则返回 `false`。 */
 bool army_move(const Coord& location, GameState &gamestate, int player, Direction direction, int num) {
     assert(location.in_map() && (player == 0 || player == 1));
-    if (num == 0) return false;
-    assert(num > 0);
+    if (num <= 0) return false; // 起点兵力不足1时，`__execute_operation`截断所得的兵力数为负
 
     Cell& cell = gamestate[location];
 
@@ -58,41 +56,38 @@ bool army_move(const Coord& location, GameState &gamestate, int player, Directio
     if (gamestate.rest_move_step[player] == 0) return false;
     if (num > cell.army - 1) return false;
 
-    for (SuperWeapon &sw : gamestate.active_super_weapon) { // 超级武器效果
-        if (sw.position == location && sw.rest &&
-            sw.type == WeaponType::TRANSMISSION && sw.player == player) return false; // 超时空传送眩晕
-        if (location.in_super_weapon_range(sw.position) && sw.rest && sw.type == WeaponType::TIME_STOP)
-            return false; // 时间暂停效果
-    }
+    // 超级武器效果
+    if (cell.weapon_active(WeaponType::TRANSMISSION, player)) return false; // 超时空传送眩晕
+    if (cell.weapon_active(WeaponType::TIME_STOP)) return false; // 时间暂停效果
 
     const Coord& new_position = location + DIRECTION_ARR[direction];
+    if (!new_position.in_map()) return false; // 越界
     Cell& new_cell = gamestate[new_position];
 
-    if (!new_position.in_map()) return false; // 越界
     if (new_cell.type == CellType::SWAMP && gamestate.tech_level[player][1] == 0) return false; // 不能经过沼泽
 
     if (new_cell.player == player) { // 目的地格子己方所有
-        new_cell.army += num;
-        cell.army -= num;
+        gamestate.set_cell_army(new_cell, new_cell.army + num);
+        gamestate.set_cell_army(cell, cell.army - num);
     } else if (new_cell.player == 1 - player || new_cell.player == -1) { // 攻击敌方或无主格子
         float attack = gamestate.attack_multiplier(location);
         float defence = gamestate.defence_multiplier(new_position);
         float vs = num * attack - new_cell.army * defence;
         if (vs > 0) { // 攻下
-            new_cell.player = player;
-            new_cell.army = (int)(std::ceil(vs / attack));
-            cell.army -= num;
-            if (new_cell.generals != nullptr) new_cell.generals->player = player; // 将军易主
+            gamestate.set_cell_player(new_cell, player);
+            gamestate.set_cell_army(new_cell, (int)(std::ceil(vs / attack)));
+            gamestate.set_cell_army(cell, cell.army - num);
+            if (new_cell.has_general()) gamestate.set_general_player(*gamestate.generals[new_cell.general_slot], player); // 将军易主
         } else if (vs < 0) { // 防住
-            new_cell.army = (int)(std::ceil((-vs) / defence));
-            cell.army -= num;
+            gamestate.set_cell_army(new_cell, (int)(std::ceil((-vs) / defence)));
+            gamestate.set_cell_army(cell, cell.army - num);
         } else if (vs == 0) { // 中立
-            if (new_cell.generals == nullptr) new_cell.player = -1;
-            new_cell.army = 0;
-            cell.army -= num;
+            if (!new_cell.has_general()) gamestate.set_cell_player(new_cell, -1);
+            gamestate.set_cell_army(new_cell, 0);
+            gamestate.set_cell_army(cell, cell.army - num);
         }
     }
-    gamestate.rest_move_step[player] -= 1;
+    gamestate.assign(gamestate.rest_move_step[player], gamestate.rest_move_step[player] - 1);
     return true;
 }
 
@@ -110,54 +105,29 @@ std::pair<bool, int> check_general_movement(const Coord& location, GameState &ga
 
     Cell& cell = gamestate[location];
     if (player != 0 && player != 1) return std::make_pair(false, -1); // 玩家非法
-    if (cell.player != player || cell.generals == nullptr) return std::make_pair(false, -1); // 起始格子非法
+    if (cell.player != player || !cell.has_general()) return std::make_pair(false, -1); // 起始格子非法
 
     // 油井不能移动
-    OilWell *oilWellPtr = dynamic_cast<OilWell *>(cell.generals);
-    if (oilWellPtr) return std::make_pair(false, -1);
-
-    for (SuperWeapon &sw : gamestate.active_super_weapon) {
-        if (sw.position == location && sw.rest &&
-            sw.type == WeaponType::TRANSMISSION && sw.player == player) return std::make_pair(false, -1); // 超时空传送眩晕
-        if (location.in_super_weapon_range(sw.position) && sw.rest && sw.type == WeaponType::TIME_STOP)
-            return std::make_pair(false, -1); // 时间暂停效果
-    }
+    const Generals* general = gamestate.generals[cell.general_slot];
+    if (general->type == GeneralType::OIL_WELL) return std::make_pair(false, -1);
 
-    // bfs检查可移动性
-    int op = -1, cl = 0;
-    std::vector<Coord> queue;
-    std::vector<int> steps;
-    static bool check[Constant::row][Constant::col];
-    memset(check, 0, sizeof(check));
-
-    queue.emplace_back(location);
-    steps.push_back(0);
-    check[location.x][location.y] = true;
-
-    int rest_move = cell.generals->rest_move;
-    while (op < cl) {
-        op += 1;
-        if (steps[op] > rest_move) break; // 步数超限
-        if (queue[op] == destination) return std::make_pair(true, steps[op]); // 到达目的地
-
-        int p = queue[op].x, q = queue[op].y;
-        for (const auto &direction : DIRECTION_ARR) {
-            Coord new_coord = Coord(p, q) + direction;
-            int newP = p + direction.x, newQ = q + direction.y;
-
-            if (!new_coord.in_map()) continue; // 越界
-            if (check[newP][newQ]) continue; // 已入队
-            if (!gamestate.can_general_step_on(new_coord, player)) continue; // 无法经过沼泽
-            if (gamestate[new_coord].player != player || gamestate[new_coord].generals != nullptr)
-                continue; // 目的地格子非法
-            queue.push_back(new_coord); // 入队
-            cl += 1;
-            steps.push_back(steps[op] + 1);
-            check[newP][newQ] = true;
-        }
+    // 超级武器效果
+    if (cell.weapon_active(WeaponType::TRANSMISSION, player)) return std::make_pair(false, -1); // 超时空传送眩晕
+    if (cell.weapon_active(WeaponType::TIME_STOP)) return std::make_pair(false, -1); // 时间暂停效果
+
+    // 逐层洪泛检查可移动性：第k层即恰好k步可达的格子
+    const Board_planes& planes = gamestate.planes;
+    Bitboard passable = planes.owned[player] & ~planes.occupied; // 只能经过己方无将领的格子
+    if (!gamestate.has_swamp_tech(player)) passable &= ~planes.swamp; // 无法经过沼泽
+
+    Bitboard reached = Bitboard::single(location), frontier = reached;
+    for (int step = 0; step <= general->rest_move && frontier.any(); ++step) {
+        if (frontier.test(destination)) return std::make_pair(true, step); // 到达目的地
+        frontier = frontier.dilate() & passable & ~reached;
+        reached |= frontier;
     }
 
-    // bfs结束，没到达目的地
+    // 步数耗尽，没到达目的地
     return std::make_pair(false, -1);
 }
 
@@ -174,10 +144,11 @@ bool general_move(const Coord& location, GameState &gamestate, int player, const
     std::pair<bool, int> able = check_general_movement(location, gamestate, player, destination);
     if (!able.first) return false;
 
-    gamestate[destination].generals = gamestate[location].generals;
-    gamestate[destination].generals->position = destination;
-    gamestate[destination].generals->rest_move -= able.second;
-    gamestate[location].generals = nullptr;
+    Generals* general = gamestate.general_at(location);
+    gamestate.set_cell_general(gamestate[destination], gamestate[location].general_slot);
+    gamestate.set_cell_general(gamestate[location], -1);
+    gamestate.assign(general->position, destination);
+    gamestate.assign(general->rest_move, general->rest_move - able.second);
 
     return true;
 }
@@ -200,14 +171,14 @@ bool army_rush(const Coord& location, GameState &gamestate, int player, const Co
 
     // 如果目标位置没有玩家
     if (new_cell.player == -1) {
-        new_cell.army += num;
-        old_cell.army -= num;
-        new_cell.player = player; // 设置目标位置的玩家
+        gamestate.set_cell_army(new_cell, new_cell.army + num);
+        gamestate.set_cell_army(old_cell, old_cell.army - num);
+        gamestate.set_cell_player(new_cell, player); // 设置目标位置的玩家
     }
     // 如果目标位置是当前玩家
     else if (new_cell.player == player) {
-        old_cell.army -= num;		   // 减少当前位置的军队数量
-        new_cell.army += num; // 增加目标位置的军队数量
+        gamestate.set_cell_army(old_cell, old_cell.army - num);		   // 减少当前位置的军队数量
+        gamestate.set_cell_army(new_cell, new_cell.army + num); // 增加目标位置的军队数量
     }
     // 如果目标位置是对手玩家
     else if (new_cell.player == 1 - player) {
@@ -220,9 +191,9 @@ bool army_rush(const Coord& location, GameState &gamestate, int player, const Co
             assert(!"army_rush error: vs < 0");
         }
 
-        new_cell.player = player;
-        new_cell.army = (int)(std::ceil(vs / attack));
-        old_cell.army -= num;
+        gamestate.set_cell_player(new_cell, player);
+        gamestate.set_cell_army(new_cell, (int)(std::ceil(vs / attack)));
+        gamestate.set_cell_army(old_cell, old_cell.army - num);
     }
     return true; // 返回成功
 }
@@ -243,9 +214,9 @@ bool check_rush_param(int player, const Coord& destination, const Coord& locatio
     const Cell& new_cell = gamestate[destination];
 
     // 检查参数合理性
-    if (old_cell.generals == nullptr) return false; // 如果当前位置没有将军，返回失败
+    if (!old_cell.has_general()) return false; // 如果当前位置没有将军，返回失败
     if (old_cell.army < 2) return false; // 如果当前位置的军队数量小于2，返回失败
-    if (new_cell.generals != nullptr) return false; // 如果目标位置有将军，返回失败
+    if (new_cell.has_general()) return false; // 如果目标位置有将军，返回失败
     if (new_cell.type == CellType::SWAMP && gamestate.tech_level[player][static_cast<int>(TechType::IMMUNE_SWAMP)] == 0)
         return false; // 如果目标位置是沼泽且玩家没有免疫沼泽技能，返回失败
 
@@ -254,6 +225,11 @@ bool check_rush_param(int player, const Coord& destination, const Coord& locatio
         int num = old_cell.army - 1; // 计算移动的军队数量
         float vs = num * gamestate.attack_multiplier(location) - new_cell.army * gamestate.defence_multiplier(destination);
         if (vs <= 0) return false; // 如果战斗结果为负，返回失败
+
+        // `army_rush`在将领移至目标格之后才计算战斗结果，此时目标格仍归对手，须同样能攻下
+        float attack = gamestate.attack_multiplier_after_move(location, destination, location, player);
+        vs = num * attack - new_cell.army * gamestate.defence_multiplier_after_move(location, destination, destination);
+        if (vs <= 0) return false;
     }
     return true; // 返回成功
 }
@@ -271,11 +247,11 @@ bool handle_breakthrough(const Coord& destination, GameState &gamestate) {
 
     // 如果目标位置的军队数量大于20
     if (gamestate.board[x][y].army > Constant::STRIKE_DAMAGE)
-        gamestate.board[x][y].army -= Constant::STRIKE_DAMAGE; // 减少目标位置的军队数量
+        gamestate.set_cell_army(gamestate.board[x][y], gamestate.board[x][y].army - Constant::STRIKE_DAMAGE); // 减少目标位置的军队数量
     else {
-        gamestate.board[x][y].army = 0; // 设置目标位置的军队数量为0
+        gamestate.set_cell_army(gamestate.board[x][y], 0); // 设置目标位置的军队数量为0
         // 如果目标位置没有将军，则设置目标位置没有玩家
-        if (gamestate.board[x][y].generals == nullptr) gamestate.board[x][y].player = -1;
+        if (!gamestate.board[x][y].has_general()) gamestate.set_cell_player(gamestate.board[x][y], -1);
     }
     return true; // 返回成功
 }
@@ -304,16 +280,13 @@ bool skill_activate(int player, const Coord& location, const Coord& destination,
     // 检查参数合理性
     if (gamestate[location].player != player) return false; // 如果指定位置上的玩家不是当前玩家，则返回false
     int coin = gamestate.coin[player];
-    Generals *general = gamestate[location].generals;
+    Generals *general = gamestate.general_at(location);
     if (general == nullptr) return false; // 如果指定位置上没有将领，则返回false
 
     // 超级武器效果
-    for (SuperWeapon &sw : gamestate.active_super_weapon) {
-        if (sw.position == location && sw.rest &&
-            sw.type == WeaponType::TRANSMISSION && sw.player == player) return false; // 超时空传送眩晕
-        if (sw.position.in_super_weapon_range(location) && sw.rest && sw.type == WeaponType::TIME_STOP)
-            return false; // 时间暂停效果
-    }
+    const Cell& cell = gamestate[location];
+    if (cell.weapon_active(WeaponType::TRANSMISSION, player)) return false; // 超时空传送眩晕
+    if (cell.weapon_active(WeaponType::TIME_STOP)) return false; // 时间暂停效果
 
     assert(skillType >= SkillType::RUSH && skillType <= SkillType::WEAKEN);
     if (coin < skillType.cost() || general->skills_cd[static_cast<int>(skillType)] > 0)
@@ -322,16 +295,16 @@ bool skill_activate(int player, const Coord& location, const Coord& destination,
     if (skillType == SkillType::RUSH) {
         if (!check_rush_param(player, destination, location, gamestate)) return false; // 如果突袭技能的参数不合法，则返回false
 
-        general->position = destination;
-        gamestate[destination].generals = general;
-        gamestate[location].generals = nullptr;
+        gamestate.assign(general->position, destination);
+        gamestate.set_cell_general(gamestate[destination], gamestate[location].general_slot);
+        gamestate.set_cell_general(gamestate[location], -1);
         army_rush(location, gamestate, player, destination);
     } else if (skillType == SkillType::STRIKE) {
         if (!handle_breakthrough(destination, gamestate)) return false;
     }
-    gamestate.coin[player] -= skillType.cost();
-    general->skills_cd[static_cast<int>(skillType)] = skillType.cd();
-    general->skill_duration[static_cast<int>(skillType)] = skillType.duration();
+    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - skillType.cost());
+    gamestate.set_skill_cd(*general, skillType, skillType.cd());
+    gamestate.set_skill_duration(*general, skillType, skillType.duration());
     return true;
 }
 
@@ -354,9 +327,9 @@ bool bomb(GameState &gamestate, const Coord& location, int player) {
     int cd = gamestate.super_weapon_cd[player];
     if (is_super_weapon_unlocked && cd == 0) {
         // 激活超级武器
-        gamestate.active_super_weapon.push_back(SuperWeapon(WeaponType::NUCLEAR_BOOM, player, 0, 5, location));
+        gamestate.add_super_weapon(SuperWeapon(WeaponType::NUCLEAR_BOOM, player, 0, 5, location));
         // 设置超级武器的冷却时间
-        gamestate.super_weapon_cd[player] = Constant::SUPER_WEAPON_CD;
+        gamestate.assign(gamestate.super_weapon_cd[player], Constant::SUPER_WEAPON_CD);
 
         // 处理炸弹效果
         // 遍历目标位置周围的单元格
@@ -368,20 +341,19 @@ bool bomb(GameState &gamestate, const Coord& location, int player) {
 
                 Cell &cell = gamestate[coord];
                 // 如果单元格中有主将，军队数量减半
-                if (dynamic_cast<MainGenerals *>(cell.generals)) cell.army = (int)(cell.army / 2);
+                Generals* general = gamestate.general_at(coord);
+                if (general && general->type == GeneralType::MAIN_GENERAL) gamestate.set_cell_army(cell, (int)(cell.army / 2));
                 else { // 否则，清空单元格
-                    cell.army = 0;
-                    cell.player = -1;
-                    cell.generals = nullptr;
-
-                    auto it = gamestate.generals.begin();
-                    // 从将军列表中移除该将军
-                    while (it != gamestate.generals.end()) {
-                        if ((*it)->position == coord) {
-                            it = gamestate.generals.erase(it);
+                    gamestate.set_cell_army(cell, 0);
+                    gamestate.set_cell_player(cell, -1);
+                    gamestate.set_cell_general(cell, -1);
+
+                    // 将该位置的将军标记为已摧毁，其槽位保留在将领池中
+                    for (Generals* gen : gamestate.generals) {
+                        if (gen->position == coord) {
+                            gamestate.destroy_general(*gen);
                             break;
                         }
-                        it++;
                     }
                 }
             }
@@ -403,17 +375,16 @@ bool bomb(GameState &gamestate, const Coord& location, int player) {
 bool strengthen(GameState &gamestate, const Coord& location, int player) {
     // 检查玩家和位置的有效性
     if (player != 0 && player != 1) return false;
-    if (location.x < 0 || location.x > Constant::row) return false;
-    if (location.y < 0 || location.y > Constant::col) return false;
+    if (!location.in_map()) return false;
 
     // 检查超级武器是否解锁并且冷却时间为0
     bool is_super_weapon_unlocked = gamestate.super_weapon_unlocked[player];
     int cd = gamestate.super_weapon_cd[player];
     if (is_super_weapon_unlocked && cd == 0) {
         // 激活超级武器
-        gamestate.active_super_weapon.push_back(SuperWeapon(WeaponType::ATTACK_ENHANCE, player, 5, 5, location));
+        gamestate.add_super_weapon(SuperWeapon(WeaponType::ATTACK_ENHANCE, player, 5, 5, location));
         // 设置超级武器的冷却时间
-        gamestate.super_weapon_cd[player] = Constant::SUPER_WEAPON_CD;
+        gamestate.assign(gamestate.super_weapon_cd[player], Constant::SUPER_WEAPON_CD);
         return true;
     }
     return false;
@@ -446,7 +417,7 @@ bool tp(GameState &gamestate, const Coord& start, const Coord& to, int player) {
         if (cell_st.player != player) return false;
 
         // 检查目标位置是否已被占据
-        if (cell_to.generals != nullptr) return false;
+        if (cell_to.has_general()) return false;
 
         // 检查目标位置是否为沼泽且玩家无沼泽免疫
         if (cell_to.type == CellType::SWAMP && gamestate.tech_level[player][static_cast<int>(TechType::IMMUNE_SWAMP)] == 0)
@@ -454,11 +425,11 @@ bool tp(GameState &gamestate, const Coord& start, const Coord& to, int player) {
 
         if (cell_st.army <= 1) return false;
 
-        cell_to.army = cell_st.army - 1;
-        cell_st.army = 1;
-        cell_to.player = player;
-        gamestate.super_weapon_cd[player] = Constant::SUPER_WEAPON_CD;
-        gamestate.active_super_weapon.push_back(SuperWeapon(WeaponType::TRANSMISSION, player, 2, 2, to));
+        gamestate.set_cell_army(cell_to, cell_st.army - 1);
+        gamestate.set_cell_army(cell_st, 1);
+        gamestate.set_cell_player(cell_to, player);
+        gamestate.assign(gamestate.super_weapon_cd[player], Constant::SUPER_WEAPON_CD);
+        gamestate.add_super_weapon(SuperWeapon(WeaponType::TRANSMISSION, player, 2, 2, to));
         return true;
     }
     return false;
@@ -483,8 +454,8 @@ bool timestop(GameState &gamestate, const Coord& location, int player) {
     bool is_super_weapon_unlocked = gamestate.super_weapon_unlocked[player];
     int cd = gamestate.super_weapon_cd[player];
     if (is_super_weapon_unlocked && cd == 0) {
-        gamestate.active_super_weapon.push_back(SuperWeapon(WeaponType::TIME_STOP, player, 10, 10, location));
-        gamestate.super_weapon_cd[player] = Constant::SUPER_WEAPON_CD;
+        gamestate.add_super_weapon(SuperWeapon(WeaponType::TIME_STOP, player, 10, 10, location));
+        gamestate.assign(gamestate.super_weapon_cd[player], Constant::SUPER_WEAPON_CD);
         return true;
     }
     return false;
@@ -500,10 +471,10 @@ bool timestop(GameState &gamestate, const Coord& location, int player) {
 * 返回值：如果技术升级成功，返回 `true`；否则返回 `false`。 */
 bool production_up(const Coord& location, GameState &gamestate, int player) {
     Cell& cell = gamestate[location];
-    if (cell.generals == nullptr) return false;
+    if (!cell.has_general()) return false;
     if (cell.player != player) return false;
 
-    return cell.generals->production_up(gamestate, player);
+    return gamestate.generals[cell.general_slot]->production_up(gamestate, player);
 }
 
 /* ### `bool defence_up(const Coord& location, GameState &gamestate, int player)`
@@ -516,10 +487,10 @@ bool production_up(const Coord& location, GameState &gamestate, int player) {
 * 返回值：如果技术升级成功，返回 `true`；否则返回 `false`。 */
 bool defence_up(const Coord& location, GameState &gamestate, int player) {
     Cell& cell = gamestate.board[location.x][location.y];
-    if (cell.generals == nullptr) return false;
+    if (!cell.has_general()) return false;
     if (cell.player != player) return false;
 
-    return cell.generals->defence_up(gamestate, player);
+    return gamestate.generals[cell.general_slot]->defence_up(gamestate, player);
 }
 
 /* ### `bool movement_up(const Coord& location, GameState &gamestate, int player)`
@@ -532,10 +503,11 @@ bool defence_up(const Coord& location, GameState &gamestate, int player) {
 * 返回值：如果技术升级成功，返回 `true`；否则返回 `false`。 */
 bool movement_up(const Coord& location, GameState &gamestate, int player) {
     Cell& cell = gamestate.board[location.x][location.y];
-    if (cell.generals == nullptr) return false;
+    if (!cell.has_general()) return false;
     if (cell.player != player) return false;
+    if (gamestate.generals[cell.general_slot]->type == GeneralType::OIL_WELL) return false; // 油井没有移动力
 
-    return cell.generals->movement_up(gamestate, player);
+    return gamestate.generals[cell.general_slot]->movement_up(gamestate, player);
 }
 
 /*
@@ -552,9 +524,9 @@ bool tech_update(TechType tech_type, GameState &gamestate, int player) {
                 if (gamestate.tech_level[player][static_cast<int>(tech_type)] == Constant::PLAYER_MOVEMENT_VALUES[i]) {
                     if (gamestate.coin[player] < Constant::PLAYER_MOVEMENT_COST[i]) return false;
 
-                    gamestate.coin[player] -= Constant::PLAYER_MOVEMENT_COST[i];
-                    gamestate.rest_move_step[player] = Constant::PLAYER_MOVEMENT_VALUES[i + 1]; // 【立即恢复移动步数（未说明的feature）】
-                    gamestate.tech_level[player][static_cast<int>(tech_type)] = Constant::PLAYER_MOVEMENT_VALUES[i + 1];
+                    gamestate.assign(gamestate.coin[player], gamestate.coin[player] - Constant::PLAYER_MOVEMENT_COST[i]);
+                    gamestate.assign(gamestate.rest_move_step[player], Constant::PLAYER_MOVEMENT_VALUES[i + 1]); // 【立即恢复移动步数（未说明的feature）】
+                    gamestate.assign(gamestate.tech_level[player][static_cast<int>(tech_type)], Constant::PLAYER_MOVEMENT_VALUES[i + 1]);
                     return true;
                 }
             }
@@ -566,8 +538,8 @@ bool tech_update(TechType tech_type, GameState &gamestate, int player) {
         case TechType::IMMUNE_SWAMP:
             if (gamestate.tech_level[player][1] == 0) {
                 if (gamestate.coin[player] < Constant::swamp_immunity) return false;
-                gamestate.tech_level[player][1] = 1;
-                gamestate.coin[player] -= Constant::swamp_immunity;
+                gamestate.assign(gamestate.tech_level[player][1], 1);
+                gamestate.assign(gamestate.coin[player], gamestate.coin[player] - Constant::swamp_immunity);
                 return true;
             }
             return false;
@@ -575,8 +547,8 @@ bool tech_update(TechType tech_type, GameState &gamestate, int player) {
         case TechType::IMMUNE_SAND:
             if (gamestate.tech_level[player][2] == 0) {
                 if (gamestate.coin[player] < Constant::sand_immunity) return false;
-                gamestate.tech_level[player][2] = 1;
-                gamestate.coin[player] -= Constant::sand_immunity;
+                gamestate.assign(gamestate.tech_level[player][2], 1);
+                gamestate.assign(gamestate.coin[player], gamestate.coin[player] - Constant::sand_immunity);
                 return true;
             }
             return false;
@@ -584,10 +556,10 @@ bool tech_update(TechType tech_type, GameState &gamestate, int player) {
         case TechType::UNLOCK:
             if (gamestate.tech_level[player][3] == 0) {
                 if (gamestate.coin[player] < Constant::unlock_super_weapon) return false;
-                gamestate.tech_level[player][3] = 1;
-                gamestate.super_weapon_cd[player] = 10;
-                gamestate.super_weapon_unlocked[player] = true;
-                gamestate.coin[player] -= Constant::unlock_super_weapon;
+                gamestate.assign(gamestate.tech_level[player][3], 1);
+                gamestate.assign(gamestate.super_weapon_cd[player], 10);
+                gamestate.assign(gamestate.super_weapon_unlocked[player], true);
+                gamestate.assign(gamestate.coin[player], gamestate.coin[player] - Constant::unlock_super_weapon);
                 return true;
             }
             return false;
@@ -598,8 +570,8 @@ bool tech_update(TechType tech_type, GameState &gamestate, int player) {
     return false;
 }
 
-// 执行单个操作，返回是否成功
-bool execute_operation(GameState &game_state, int player, const Operation &op) {
+// 执行单个操作的内部实现，不处理撤销日志；`verbose`为假时不输出日志
+bool __execute_operation(GameState &game_state, int player, const Operation &op, bool verbose) {
     // 获取操作码和操作数
     OperationType command = op.opcode;
     const int* params = op.operand;
@@ -610,7 +582,7 @@ bool execute_operation(GameState &game_state, int player, const Operation &op) {
         case OperationType::MOVE_ARMY: {
             int real_army = params[3];
             if (real_army > game_state[{params[0], params[1]}].army - 1) {
-                logger.log(LOG_LEVEL_ERROR, "\t\tInvalid army count for op MOVE_ARMY: %s %d %d, truncated to %d",
+                if (verbose) logger.log(LOG_LEVEL_ERROR, "\t\tInvalid army count for op MOVE_ARMY: %s %d %d, truncated to %d",
                            Coord(params[0], params[1]).str().c_str(), params[2], real_army, game_state[{params[0], params[1]}].army - 1);
                 real_army = game_state[{params[0], params[1]}].army - 1;
             }
@@ -683,6 +655,20 @@ bool execute_operation(GameState &game_state, int player, const Operation &op) {
     return false;
 }
 
+// 执行单个操作，返回是否成功；`verbose`为假时不输出日志
+// 若`game_state`挂接了撤销日志，成功的操作计为日志中的一个操作，失败的操作则立即回滚、不留记录
+bool execute_operation(GameState &game_state, int player, const Operation &op, bool verbose = true) {
+    Undo_journal* journal = game_state.journal;
+    if (journal) {
+        journal->begin_op();
+        journal->save(game_state.zobrist); // 哈希值随操作整体回滚
+    }
+
+    bool success = __execute_operation(game_state, player, op, verbose);
+    if (!success && journal) journal->undo(1);
+    return success;
+}
+
 // 执行一系列操作，返回是否成功
 bool execute_operations(GameState &game_state, const Operation_list& operations) {
     for (const Operation& op : operations)
@@ -6,16 +6,17 @@
 #include <cmath>
 #include <queue>
 #include <chrono>
+#include <memory>
 #include <cstdlib>
 #include <optional>
 
 class Oil_cluster {
 public:
     double total_dist;
-    const OilWell* center_well;
-    std::vector<const OilWell*> wells;
+    const Generals* center_well;
+    std::vector<const Generals*> wells;
 
-    Oil_cluster(const OilWell* center_well) noexcept : total_dist(0.0), center_well(center_well) {}
+    Oil_cluster(const Generals* center_well) noexcept : total_dist(0.0), center_well(center_well) {}
     bool operator<(const Oil_cluster& other) const noexcept {
         if (wells.size() == other.wells.size()) return total_dist < other.total_dist;
         return wells.size() < other.wells.size();
@@ -23,7 +24,7 @@ public:
 
     // 将距离敌方近的油井排在前面
     void sort_wells(const Dist_map& enemy_dist) noexcept {
-        std::sort(wells.begin(), wells.end(), [&enemy_dist](const OilWell* a, const OilWell* b) {
+        std::sort(wells.begin(), wells.end(), [&enemy_dist](const Generals* a, const Generals* b) {
             return enemy_dist[a->position] < enemy_dist[b->position];
         });
     }
@@ -31,7 +32,7 @@ public:
     // 获取描述字符串
     std::string str() const noexcept {
         std::string ret{wrap("Cluster size %d with center %s, total distance %.0f:", wells.size(), center_well->position.str().c_str(), total_dist)};
-        for (const OilWell* well : wells) ret += wrap(" %s", well->position.str().c_str());
+        for (const Generals* well : wells) ret += wrap(" %s", well->position.str().c_str());
         return ret;
     }
 };
@@ -108,6 +109,9 @@ public:
     // 站在敌方立场进行路径搜索时的额外开销，体现了我方的威慑范围
     int enemy_pathfind_cost[Constant::col][Constant::row];
 
+    // 试探执行用的暂存状态，各处试探互不嵌套，共用一份以免大地图下每处在栈上占用一整个`GameState`
+    GameState scratch_state;
+
     void main_process() {
         // 初始操作
         if (game_state.round == 1) {
@@ -130,8 +134,8 @@ public:
         // 识别民兵冲锋的策略
         identify_militia_strategy();
 
-        const MainGenerals* main_general = dynamic_cast<const MainGenerals*>(game_state.generals[my_seat]);
-        const MainGenerals* enemy_general = dynamic_cast<const MainGenerals*>(game_state.generals[1 - my_seat]);
+        const Generals* main_general = game_state.main_general(my_seat);
+        const Generals* enemy_general = game_state.main_general(1 - my_seat);
         int my_army = game_state[main_general->position].army;
         int enemy_army = game_state[enemy_general->position].army;
         int army_around_enemy = 0; // 敌方主将旁边的军队数量
@@ -140,13 +144,6 @@ public:
             if (new_pos.in_map() && game_state[new_pos].player == 1 - my_seat)
                 army_around_enemy = std::max(army_around_enemy, game_state[new_pos].army);
         }
-        int max_single_army = 0;
-        for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
-            const Cell& cell = game_state[Coord{x, y}];
-            if (cell.player != 1 - my_seat) continue;
-            if (cell.generals && !dynamic_cast<const OilWell*>(cell.generals)) continue;
-            max_single_army = std::max(max_single_army, cell.army);
-        }
         enemy_army += army_around_enemy;
 
         // 参数更新
@@ -190,7 +187,7 @@ public:
 
         // 进攻搜索
         Attack_searcher searcher(my_seat, game_state);
-        std::optional<Attack_info> ret = searcher.search();
+        const Attack_info* ret = searcher.search();
         if (ret) {
             logger.log(LOG_LEVEL_INFO, "Critical tactic found");
             for (const Operation& op : ret->ops) {
@@ -231,7 +228,7 @@ public:
                 if (!plan) continue;
                 if (plan->army_used < step) continue; // 性价比太低
 
-                if (!best_plan || plan->army_used > best_plan->army_used) best_plan = plan;
+                if (!best_plan || plan->army_used > best_plan->army_used) best_plan = std::move(plan);
             }
             if (best_plan) {
                 militia_task.emplace(Militia_action_type::SUPPORT, *best_plan, game_state.round);
@@ -253,6 +250,8 @@ public:
 
         // 民兵任务分配与移动
         militia_move();
+
+        logger.log(LOG_LEVEL_INFO, "[Attack cache] hit %d, miss %d", Attack_searcher::cache.hit_count, Attack_searcher::cache.miss_count);
     }
 
     [[noreturn]] void run() {
@@ -260,8 +259,9 @@ public:
         while (true) {
             // 先手
             if (my_seat == 0) {
-                // 给出操作
+                // 给出操作，随后整体释放本回合分析器的临时内存
                 main_process();
+                turn_arena.release();
                 // 向judger发送操作
                 send_ops();
                 // 读取并应用敌方操作
@@ -274,8 +274,9 @@ public:
             else {
                 // 读取并应用敌方操作
                 read_and_apply_enemy_ops();
-                // 给出操作
+                // 给出操作，随后整体释放本回合分析器的临时内存
                 main_process();
+                turn_arena.release();
                 // 向judger发送操作
                 send_ops();
                 // 更新回合
@@ -295,25 +296,24 @@ private:
         std::vector<Oil_cluster> clusters;
 
         // 计算双方距离
-        Dist_map my_dist(game_state, game_state.generals[my_seat]->position, {2.0}); // 沙漠视为2格
-        Dist_map enemy_dist(game_state, game_state.generals[1 - my_seat]->position, {2.0});
+        Dist_map my_dist(game_state, game_state.main_general(my_seat)->position, {2.0}); // 沙漠视为2格
+        Dist_map enemy_dist(game_state, game_state.main_general(1 - my_seat)->position, {2.0});
 
         // 考虑各个油井作为中心的可能性
-        for (int i = 0, siz = game_state.generals.size(); i < siz; ++i) {
-            const OilWell* center_well = dynamic_cast<const OilWell*>(game_state.generals[i]);
-            if (center_well == nullptr || game_state[center_well->position].type == CellType::SWAMP) continue;
+        const Slot_set& oil_wells = game_state.generals.of_kind(GeneralType::OIL_WELL);
+        for (const Generals* center_well : game_state.generals.in(oil_wells)) {
+            if (game_state[center_well->position].type == CellType::SWAMP) continue;
 
             // 计算距离
             int my_dist_to_center = my_dist[center_well->position];
-            int enemy_dist_to_center = enemy_dist[center_well->position] / game_state.generals[1 - my_seat]->mobility_level;
+            int enemy_dist_to_center = enemy_dist[center_well->position] / game_state.main_general(1 - my_seat)->mobility_level;
             Dist_map dist_map(game_state, center_well->position, {2.0});
 
             // 搜索其它油井
             Oil_cluster cluster(center_well);
             cluster.wells.push_back(center_well);
-            for (int j = 0; j < siz; ++j) {
-                const OilWell* well = dynamic_cast<const OilWell*>(game_state.generals[j]);
-                if (well == nullptr || j == i) continue;
+            for (const Generals* well : game_state.generals.in(oil_wells)) {
+                if (well == center_well) continue;
 
                 if (dist_map[well->position] <= MAX_DIST && enemy_dist[well->position] >= MIN_ENEMY_DIST) {
                     cluster.wells.push_back(well);
@@ -347,20 +347,16 @@ private:
         static double feature_score = 0;
         static int prev_oilfield_state[16] = {};
         if (game_state.round == 1) {
-            for (int i = 0, j = 0, siz = game_state.generals.size(); i < siz; ++i) {
-                const OilWell* well = dynamic_cast<const OilWell*>(game_state.generals[i]);
-                if (well == nullptr) continue;
-                prev_oilfield_state[j++] = well->player;
-            }
+            int j = 0;
+            for (const Generals* well : game_state.generals.in(game_state.generals.of_kind(GeneralType::OIL_WELL))) prev_oilfield_state[j++] = well->player;
             return;
         } else if (game_state.round > MAX_IDENTIFY_TIME) return;
 
-        const MainGenerals* enemy_general = dynamic_cast<const MainGenerals*>(game_state.generals[1 - my_seat]);
+        const Generals* enemy_general = game_state.main_general(1 - my_seat);
 
         // 特征：有距离敌方主将很远的油井被占领
-        for (int i = 0, j = 0, siz = game_state.generals.size(); i < siz; ++i) {
-            const OilWell* well = dynamic_cast<const OilWell*>(game_state.generals[i]);
-            if (well == nullptr) continue;
+        int j = 0;
+        for (const Generals* well : game_state.generals.in(game_state.generals.of_kind(GeneralType::OIL_WELL))) {
             // 油井被敌方占领
             if (well->player == 1 - my_seat && prev_oilfield_state[j] != 1 - my_seat) {
                 Dist_map dist_map(game_state, well->position, Path_find_config{1.0, false, false});
@@ -380,8 +376,8 @@ private:
 
     void assess_upgrades() {
         // 计算“相遇时间”（仅考虑主将）
-        const MainGenerals* main_general = dynamic_cast<const MainGenerals*>(game_state.generals[my_seat]);
-        const MainGenerals* enemy_general = dynamic_cast<const MainGenerals*>(game_state.generals[1 - my_seat]);
+        const Generals* main_general = game_state.main_general(my_seat);
+        const Generals* enemy_general = game_state.main_general(1 - my_seat);
         Dist_map my_dist(game_state, main_general->position, Path_find_config{1.0, game_state.has_swamp_tech(my_seat)});
         Dist_map enemy_dist(game_state, enemy_general->position, Path_find_config{1.0, game_state.has_swamp_tech(1-my_seat)});
         int approach_time = (std::min(my_dist[enemy_general->position], enemy_dist[main_general->position]) - 5 - enemy_general->mobility_level) /
@@ -395,10 +391,8 @@ private:
         Path_find_config enemy_dist_cfg(1.0, game_state.has_swamp_tech(1-my_seat));
         enemy_dist_cfg.custom_dist = enemy_pathfind_cost;
         bool unlock_upgrade_3 = main_general->produce_level >= Constant::GENERAL_PRODUCTION_VALUES[2];
-        for (int i = 0, siz = game_state.generals.size(); i < siz; ++i) {
-            const OilWell* well = dynamic_cast<const OilWell*>(game_state.generals[i]);
-            if (well == nullptr || well->player != my_seat) continue;
-
+        const Slot_set& enemies = game_state.generals.of_player(1 - my_seat);
+        for (const Generals* well : game_state.generals.in(game_state.generals.of_kind(GeneralType::OIL_WELL) & game_state.generals.of_player(my_seat))) {
             // 主将未升到产量为4时且石油有优势时，不再升级油井
             if (main_general->produce_level < Constant::GENERAL_PRODUCTION_VALUES[2] && oil_prod_advantage) break;
 
@@ -415,9 +409,8 @@ private:
             // 以油井为中心计算到敌方的距离（考虑我方威慑）
             Dist_map dist_map(game_state, well->position, enemy_dist_cfg);
             double min_dist = std::numeric_limits<double>::max();
-            for (int j = 0; j < siz; ++j) {
-                const Generals* enemy = game_state.generals[j];
-                if (enemy->player != 1 - my_seat || dynamic_cast<const OilWell*>(enemy) != nullptr) continue;
+            for (const Generals* enemy : game_state.generals.in(enemies)) {
+                if (enemy->type == GeneralType::OIL_WELL) continue;
                 min_dist = std::min(min_dist, dist_map[enemy->position]);
             }
             if (min_dist >= 6 + 3 * tire || (first_oil && game_state.round <= 15)) {
@@ -481,16 +474,16 @@ private:
     void update_strategy() {
         strategies.clear();
 
-        const MainGenerals* main_general = dynamic_cast<const MainGenerals*>(game_state.generals[my_seat]);
-        const MainGenerals* enemy_general = dynamic_cast<const MainGenerals*>(game_state.generals[1 - my_seat]);
+        const Generals* main_general = game_state.main_general(my_seat);
+        const Generals* enemy_general = game_state.main_general(1 - my_seat);
         int enemy_lookahead_oil = game_state.coin[1 - my_seat] + game_state.calc_oil_production(1 - my_seat) * 2; // 取两回合后的油量
 
         int my_prod = game_state.calc_oil_production(my_seat);
 
         for (int i = 0, siz = game_state.generals.size(); i < siz; ++i) {
             const Generals* general = game_state.generals[i];
-            bool is_subgeneral = dynamic_cast<const SubGenerals*>(general) != nullptr;
-            if (general->player != my_seat || dynamic_cast<const OilWell*>(general)) continue;
+            bool is_subgeneral = general->type == GeneralType::SUB_GENERAL;
+            if (!general->alive || general->player != my_seat || general->type == GeneralType::OIL_WELL) continue;
 
             int curr_army = game_state[general->position].army;
             double defence_mult = game_state.defence_multiplier(general->position);
@@ -517,10 +510,10 @@ private:
             }
 
             // 考虑是否在危险范围内（新方法）
-            GameState temp_state;
-            temp_state.copy_as(game_state);
-            Attack_searcher searcher(1-my_seat, temp_state);
-            std::optional<Attack_info> atk_search_result = searcher.search(enemy_lookahead_oil - game_state.coin[1 - my_seat]);
+            Attack_searcher searcher(1-my_seat, game_state);
+            // 结果在本轮之后的搜索后仍要使用，复制出来
+            const Attack_info* threat = searcher.search(enemy_lookahead_oil - game_state.coin[1 - my_seat]);
+            std::optional<Attack_info> atk_search_result = threat ? std::make_optional(*threat) : std::nullopt;
             int threat_eff_dist = atk_search_result ?
                 Dist_map::effect_dist(atk_search_result->origin, general->position, atk_search_result->tactic.can_rush, game_state.get_mobility(1-my_seat)) : 1000;
 
@@ -555,11 +548,12 @@ private:
             int best_well = -1;
             for (int j = PLAYER_COUNT; j < siz; ++j) {
                 const Generals* oil_well = game_state.generals[j];
-                if (oil_well->player == my_seat) continue;
-                if (dynamic_cast<const SubGenerals*>(oil_well) && !late_game) continue;
+                if (!oil_well->alive || oil_well->player == my_seat) continue;
+                if (oil_well->type == GeneralType::SUB_GENERAL && !late_game) continue;
                 if (best_well == -1 || near_map[oil_well->position] < near_map[game_state.generals[best_well]->position]) best_well = j;
             }
-            const OilWell* best_well_obj = best_well >= 0 ? dynamic_cast<const OilWell*>(game_state.generals[best_well]) : nullptr;
+            const Generals* best_well_obj = best_well >= 0 ? game_state.generals[best_well] : nullptr;
+            if (best_well_obj && best_well_obj->type != GeneralType::OIL_WELL) best_well_obj = nullptr;
             if (best_well_obj && near_map[best_well_obj->position] <= 4.0 &&
                 (!militia_task || (militia_task->type != Militia_action_type::SUPPORT && militia_task->plan.target->position != best_well_obj->position))) {
                 // 如果民兵能占领就找民兵了
@@ -569,7 +563,7 @@ private:
                 if (plan && plan->army_used <= curr_army - 1 &&
                     ((best_well_obj->player == -1 && !army_disadvantage) || curr_army - plan->army_used >= deterrence_analyzer->min_army * 1.2)) {
                     // 不能被别人威胁
-                    GameState temp_state;
+                    GameState& temp_state = scratch_state;
                     temp_state.copy_as(game_state);
                     execute_operation(temp_state, my_seat, Operation::move_army(general->position, plan->plan[0].second, plan->army_used));
 
@@ -586,7 +580,7 @@ private:
             bool defence_triggered = false;
             Path_find_config enemy_dist_cfg(1.0, game_state.has_swamp_tech(1-my_seat));
             enemy_dist_cfg.custom_dist = enemy_pathfind_cost;
-            if (cluster) for (const OilWell* well : cluster->wells) {
+            if (cluster) for (const Generals* well : cluster->wells) {
                 if (well->player != my_seat) continue;
 
                 // 若敌方的到达时间小于等于我方，则转入防御
@@ -595,9 +589,8 @@ private:
                 if (oil_dist[general->position] >= Dist_map::MAX_DIST) continue; // 无法防御走不到的油井
 
                 Dist_map enemy_dist(game_state, well->position, enemy_dist_cfg);
-                for (int j = 0; j < siz; ++j) {
-                    const Generals* enemy = game_state.generals[j];
-                    if (enemy->player != 1 - my_seat || dynamic_cast<const OilWell*>(enemy) != nullptr) continue;
+                for (const Generals* enemy : game_state.generals.in(game_state.generals.of_player(1 - my_seat))) {
+                    if (enemy->type == GeneralType::OIL_WELL) continue;
 
                     if (enemy_dist[enemy->position] / enemy->mobility_level <= my_arrival_time) {
                         strategies.emplace_back(General_strategy{i, General_strategy_type::DEFEND, Strategy_target(well->position)});
@@ -616,7 +609,7 @@ private:
             Dist_map dist_map(game_state, general->position, Path_find_config{curr_army <= 20 ? 3.0 : 2.0, game_state.has_swamp_tech(my_seat)});
             if (cluster) {
                 bool found = false;
-                for (const OilWell* well : cluster->wells) {
+                for (const Generals* well : cluster->wells) {
                     if (game_state[well->position].player != my_seat && dist_map[well->position] < Dist_map::MAX_DIST) {
                         strategies.emplace_back(General_strategy{i, General_strategy_type::OCCUPY, Strategy_target{well->position}});
                         logger.log(LOG_LEVEL_INFO, "[Allocate:occupy] General %s -> well %s (cluster)", general->position.str().c_str(), well->position.str().c_str());
@@ -731,7 +724,7 @@ private:
                 // 反之尝试分兵占领
                 else if (!militia_task || militia_task->plan.target->position != target) {
                     Militia_analyzer analyzer(game_state);
-                    auto plan = analyzer.search_plan_from_provider(game_state[target].generals, game_state.generals[my_seat]);
+                    auto plan = analyzer.search_plan_from_provider(game_state.general_at(target), game_state.main_general(my_seat));
                     // 首先兵要足够，其次不能太远
                     if (plan && plan->army_used <= curr_army - 1 &&
                         plan->plan.size() <= 8 && plan->army_used <= 0.4 * curr_army &&
@@ -771,14 +764,14 @@ private:
                     continue;
                 }
                 // 假如有问题，考虑转入“士兵先行”进攻
-                if (dynamic_cast<const MainGenerals*>(general)) {
+                if (general->type == GeneralType::MAIN_GENERAL) {
                     logger.log(LOG_LEVEL_DEBUG, "\t[Attack] Trying to attack with soldiers first:");
                     for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
                         Coord target_pos = general->position + DIRECTION_ARR[dir];
-                        if (!target_pos.in_map() || game_state[target_pos].generals) continue;
+                        if (!target_pos.in_map() || game_state[target_pos].has_general()) continue;
 
                         // 检验可行性
-                        GameState temp_state;
+                        GameState& temp_state = scratch_state;
                         temp_state.copy_as(game_state);
                         execute_operation(temp_state, my_seat, Operation::move_army(general->position, static_cast<Direction>(dir), curr_army - 1));
                         temp_state.update_round();
@@ -832,7 +825,7 @@ private:
                     enemy_pos.in_attack_range(general->position)) {
 
                     logger.log(LOG_LEVEL_DEBUG, "\t[Retreat] Move search (+strike):");
-                    GameState temp_state;
+                    GameState& temp_state = scratch_state;
                     temp_state.copy_as(game_state);
                     execute_operation(temp_state, my_seat, Operation::generals_skill(general->id, SkillType::STRIKE, enemy_pos));
 
@@ -860,7 +853,7 @@ private:
                 // 否则尝试升级防御
                 if (oil_after_op >= general->defence_upgrade_cost()) {
                     logger.log(LOG_LEVEL_DEBUG, "\t[Retreat] Move search (+defence):");
-                    GameState temp_state;
+                    GameState& temp_state = scratch_state;
                     temp_state.copy_as(game_state);
                     execute_operation(temp_state, my_seat, Operation::upgrade_generals(general->id, QualityType::DEFENCE));
 
@@ -888,7 +881,7 @@ private:
                 // 否则尝试升级行动力
                 if (general->movement_tire() == 0 && oil_after_op >= general->movement_upgrade_cost()) {
                     logger.log(LOG_LEVEL_DEBUG, "\t[Retreat] Move search (+mobility):");
-                    GameState temp_state;
+                    GameState& temp_state = scratch_state;
                     temp_state.copy_as(game_state);
                     execute_operation(temp_state, my_seat, Operation::upgrade_generals(general->id, QualityType::MOBILITY));
 
@@ -930,13 +923,13 @@ private:
             std::optional<Militia_plan> best_plan;
             for (int i = PLAYER_COUNT, siz = game_state.generals.size(); i < siz; ++i) {
                 const Generals* target = game_state.generals[i];
-                if (target->player == my_seat || !game_state.can_soldier_step_on(target->position, my_seat)) continue;
+                if (!target->alive || target->player == my_seat || !game_state.can_soldier_step_on(target->position, my_seat)) continue;
 
                 std::optional<Militia_plan> plan = analyzer.search_plan_from_militia(target);
                 if (!plan || plan->gather_steps > 7) continue;
 
                 if (!best_plan) {
-                    best_plan.emplace(plan.value());
+                    best_plan.emplace(std::move(*plan));
                     continue;
                 }
 
@@ -944,7 +937,7 @@ private:
                 bool better = false;
                 better |= (plan->plan.size() < best_plan->plan.size());
                 better |= (plan->plan.size() == best_plan->plan.size() && plan->army_used < best_plan->army_used);
-                if (better) best_plan.emplace(plan.value());
+                if (better) best_plan.emplace(std::move(*plan));
             }
 
             if (best_plan && (int)best_plan->plan.size() <= 8 * game_state.get_mobility(my_seat)) {
@@ -961,26 +954,24 @@ private:
         // 无任务则扩展
         if (!militia_task) {
             // 按照到敌方的距离升序
-            Dist_map enemy_dist(game_state, game_state.generals[1-my_seat]->position, Path_find_config{1.0, game_state.has_swamp_tech(my_seat)});
+            Dist_map enemy_dist(game_state, game_state.main_general(1-my_seat)->position, Path_find_config{1.0, game_state.has_swamp_tech(my_seat)});
             static std::vector<std::pair<int, Operation>> potential_ops;
             potential_ops.clear();
 
             // 寻找可扩展的格子
-            for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
-                Coord pos{x, y};
+            const Board_planes& planes = game_state.planes;
+            for (int idx = Board_planes::FIRST; idx < Board_planes::LAST; ++idx) {
+                if (planes.player[idx] != my_seat || planes.army[idx] <= 1) continue; // 填充列的归属为哨兵值，自然被跳过
+                Coord pos = Board_planes::coord(idx);
                 const Cell& cell = game_state[pos];
-                if (cell.player != my_seat || cell.army <= 1) continue;
-                if (cell.generals && dynamic_cast<const OilWell*>(cell.generals) == nullptr) continue; // 排除主副将格
+                if (cell.has_general() && game_state.generals[cell.general_slot]->type != GeneralType::OIL_WELL) continue; // 排除主副将格
                 if (pos == soldier_first_attack_pos) continue; // 不允许把用于攻击的兵移走
 
                 // 油田仅在周围无敌军时允许扩展
-                if (cell.generals && dynamic_cast<const OilWell*>(cell.generals)) {
+                if (cell.has_general() && game_state.generals[cell.general_slot]->type == GeneralType::OIL_WELL) {
                     bool has_enemy = false;
-                    for (int dir = 0; dir < DIRECTION_COUNT; ++dir) {
-                        Coord next_pos = pos + DIRECTION_ARR[dir];
-                        if (!next_pos.in_map()) continue;
-                        const Cell& next_cell = game_state[next_pos];
-                        if (next_cell.player == 1-my_seat && next_cell.army > 0) {
+                    for (int offset : Board_planes::DIRECTION_OFFSET) {
+                        if (planes.player[idx + offset] == 1-my_seat && planes.army[idx + offset] > 0) {
                             has_enemy = true;
                             break;
                         }
@@ -1023,7 +1014,7 @@ private:
             const Cell& cell = game_state[pos];
 
             // 是否是从主将上提取兵力的第一步操作
-            bool take_army_from_general = (cell.generals && cell.generals->id == my_seat && next_action_index == 0);
+            bool take_army_from_general = (cell.has_general() && game_state.generals[cell.general_slot]->id == my_seat && next_action_index == 0);
             if (take_army_from_general)
                 logger.log(LOG_LEVEL_INFO, "[Militia] Plan step %d, take %d army from general", next_action_index+1, militia_task->plan.army_used);
 
@@ -1034,7 +1025,7 @@ private:
                 break;
             }
             // 需要移动的格子不属于自己，或未经授权从主将取兵
-            if (cell.player != my_seat || (cell.generals && cell.generals->id == my_seat && !take_army_from_general)) {
+            if (cell.player != my_seat || (cell.has_general() && game_state.generals[cell.general_slot]->id == my_seat && !take_army_from_general)) {
                 logger.log(LOG_LEVEL_INFO, "[Militia] Plan step %d, invalid position %s (player %d, army %d)",
                            next_action_index+1, pos.str().c_str(), cell.player, cell.army);
                 militia_task.reset();
@@ -1071,7 +1062,8 @@ int main() {
     // 设置随机种子
     std::srand(std::time(nullptr));
 
-    myAI ai;
-    ai.run();
+    // `myAI`内含两份`GameState`，大地图下放在堆上
+    auto ai = std::make_unique<myAI>();
+    ai->run();
     return 0;
 }
@@ -0,0 +1,186 @@
+// 操作生成器的穷举校验：在随机对局途经的局面上逐一尝试所有可能的操作，与`generate_operations`的结果比较
+// 用法：movegen_check [games] [--seed S] [--rounds R] [--every K]
+// 对局双方每回合随机执行若干个生成的操作，每K回合校验一次双方；不一致时输出差异与局面并返回1
+// 生成器有意跳过的将领原地移动与原地传送不在穷举范围内
+// 同时在这些局面上校验局面快照：随机走出的分支经撤销后再检出，须与分支一致，且检出结束后根局面复原
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "include/mapgen.hpp"
+#include "include/cli.hpp"
+#include "include/movegen.hpp"
+#include "include/simulate.hpp"
+#include "include/test_sync.hpp"
+
+// 逐一执行所有可能的操作，记录`execute_operation`接受者；借助撤销日志，结束后`state`不变
+std::vector<std::string> sweep_operations(GameState& state, int player) {
+    std::vector<std::string> legal;
+    Undo_journal journal;
+    state.attach_journal(&journal);
+    auto attempt = [&](const Operation& op) {
+        if (!execute_operation(state, player, op, false)) return;
+        legal.push_back(op.str());
+        state.undo(1);
+    };
+
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) {
+        Coord pos(x, y);
+        for (int dir = 0; dir < DIRECTION_COUNT; ++dir)
+            for (int num = 1; num < state[pos].army; ++num) attempt(Operation::move_army(pos, static_cast<Direction>(dir), num));
+        attempt(Operation::recruit_generals(pos));
+        for (WeaponType type : {WeaponType::NUCLEAR_BOOM, WeaponType::ATTACK_ENHANCE, WeaponType::TIME_STOP})
+            attempt(Operation::use_superweapon(type, pos));
+        for (int x2 = 0; x2 < Constant::col; ++x2) for (int y2 = 0; y2 < Constant::row; ++y2)
+            if (Coord(x2, y2) != pos) attempt(Operation::use_superweapon(WeaponType::TRANSMISSION, pos, Coord(x2, y2)));
+    }
+    // 遍历时会执行操作，先取出全部将领
+    std::vector<std::pair<int, Coord>> generals;
+    for (const Generals* general : state.generals) generals.emplace_back(general->id, general->position);
+    for (const auto& [id, position] : generals) {
+        for (QualityType type : {QualityType::PRODUCTION, QualityType::DEFENCE, QualityType::MOBILITY})
+            attempt(Operation::upgrade_generals(id, type));
+        for (int i = 0; i < GENERAL_SKILL_COUNT; ++i) {
+            SkillType skill = static_cast<SkillType>(i);
+            if (skill != SkillType::RUSH && skill != SkillType::STRIKE) {
+                attempt(Operation::generals_skill(id, skill));
+                continue;
+            }
+            for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y)
+                attempt(Operation::generals_skill(id, skill, Coord(x, y)));
+        }
+        for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y)
+            if (Coord(x, y) != position) attempt(Operation::move_generals(id, Coord(x, y)));
+    }
+    for (TechType type : {TechType::MOBILITY, TechType::IMMUNE_SWAMP, TechType::IMMUNE_SAND, TechType::UNLOCK})
+        attempt(Operation::upgrade_tech(type));
+
+    state.detach_journal();
+    return legal;
+}
+
+// 取出棋盘上各格的内容，用于比较
+std::vector<Cell> board_cells(const GameState& state) {
+    std::vector<Cell> cells;
+    for (int x = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y) cells.push_back(state.board[x][y]);
+    return cells;
+}
+// 棋盘是否与取出的内容一致
+bool same_board(const GameState& state, const std::vector<Cell>& cells) {
+    for (int x = 0, i = 0; x < Constant::col; ++x) for (int y = 0; y < Constant::row; ++y, ++i) {
+        const Cell& a = state.board[x][y];
+        const Cell& b = cells[i];
+        if (a.type != b.type || a.player != b.player || a.army != b.army || a.general_slot != b.general_slot || a.weapon_status != b.weapon_status) return false;
+    }
+    return true;
+}
+
+// 随机执行若干个生成的操作作为分支并生成快照，撤销后在根局面上检出；一致时返回true，否则输出问题
+bool check_snapshot(GameState& state, int player, std::vector<Operation>& buffer, std::mt19937_64& rng) {
+    uint64_t root_zobrist = state.zobrist;
+    std::vector<Cell> root_board = board_cells(state);
+    Undo_journal journal;
+    state.attach_journal(&journal);
+    for (int i = 0, n = 1 + rng() % 6; i < n; ++i) {
+        int count = generate_operations(state, player, buffer.data(), buffer.size());
+        if (!count) break;
+        execute_operation(state, player, buffer[rng() % count], false);
+    }
+    uint64_t branch_zobrist = state.zobrist;
+    std::vector<Cell> branch_board = board_cells(state);
+    State_snapshot snapshot(state, journal);
+    state.undo(journal.op_count());
+    state.detach_journal();
+
+    const char* problem = nullptr;
+    if (state.zobrist != root_zobrist || !same_board(state, root_board)) problem = "undo did not restore the root";
+    else {
+        {
+            Snapshot_view view(state, snapshot);
+            const GameState& branch = view;
+            if (branch.zobrist != branch_zobrist || branch.calc_zobrist() != branch_zobrist) problem = "view zobrist differs from the branch";
+            else if (!same_board(branch, branch_board)) problem = "view board differs from the branch";
+        }
+        if (!problem && (state.zobrist != root_zobrist || !same_board(state, root_board))) problem = "root not restored after the view";
+    }
+    if (problem) std::printf("  snapshot (%d fields): %s\n", snapshot.field_count(), problem);
+    return !problem;
+}
+
+// 比较生成器与穷举的结果，一致时返回true，否则输出差异
+bool check_position(GameState& state, int player, std::vector<Operation>& buffer, long long& total) {
+    int count = generate_operations(state, player, buffer.data(), buffer.size(), Move_filter(Move_filter::ALL_TYPES, Bitboard::FULL, true));
+    if (count == int(buffer.size())) throw std::runtime_error("Operation buffer too small");
+    std::vector<std::string> generated;
+    for (int i = 0; i < count; ++i) generated.push_back(buffer[i].str());
+    std::vector<std::string> legal = sweep_operations(state, player);
+    std::sort(generated.begin(), generated.end());
+    std::sort(legal.begin(), legal.end());
+    total += count;
+    if (generated == legal && std::adjacent_find(generated.begin(), generated.end()) == generated.end()) return true;
+
+    std::vector<std::string> missing, extra;
+    std::set_difference(legal.begin(), legal.end(), generated.begin(), generated.end(), std::back_inserter(missing));
+    std::set_difference(generated.begin(), generated.end(), legal.begin(), legal.end(), std::back_inserter(extra));
+    for (const std::string& op : missing) std::printf("  missing: %s\n", op.c_str());
+    for (const std::string& op : extra) std::printf("  extra: %s\n", op.c_str());
+    if (missing.empty() && extra.empty()) std::printf("  duplicated operations\n");
+    return false;
+}
+
+int main(int argc, char** argv) {
+    int games = 10, rounds = 300, every = 5;
+    uint64_t seed = 0;
+    for (Arg_reader args(argc, argv, 1); args.next();) {
+        if (args.is("--seed")) seed = args.uint64_value();
+        else if (args.is("--rounds")) rounds = args.int_value();
+        else if (args.is("--every")) every = std::max(1, args.int_value());
+        else if (args.positional()) games = std::atoi(args.current());
+        else args.unknown();
+    }
+
+    std::vector<Operation> buffer(1 << 18);
+    long long positions = 0, total = 0;
+    for (int game = 0; game < games; ++game) {
+        std::mt19937_64 rng(map_seed(seed, game));
+        // 快照分支单独取随机数，不影响对局本身
+        std::mt19937_64 branch_rng(~map_seed(seed, game));
+        GameState state;
+        generate_map(state, map_seed(seed, game));
+        for (int round = 1; round <= rounds; ++round) {
+            for (int p = 0; p < PLAYER_COUNT; ++p) {
+                if (round % every == 0) {
+                    ++positions;
+                    if (!check_position(state, p, buffer, total)) {
+                        std::printf("game %d (seed %llu), round %d, player %d: generator differs from execute_operation\n",
+                                    game, (unsigned long long)seed, round, p);
+                        show_map(state, std::cout);
+                        return 1;
+                    }
+                    if (!check_snapshot(state, p, buffer, branch_rng)) {
+                        std::printf("game %d (seed %llu), round %d, player %d: snapshot check failed\n",
+                                    game, (unsigned long long)seed, round, p);
+                        show_map(state, std::cout);
+                        return 1;
+                    }
+                }
+                // 每步都从当前局面生成的操作中随机挑选，以免执行将领原地移动等被生成器排除的退化操作
+                for (int i = 0, n = 1 + rng() % 6; i < n; ++i) {
+                    int count = generate_operations(state, p, buffer.data(), buffer.size());
+                    if (!count) break;
+                    execute_operation(state, p, buffer[rng() % count], false);
+                }
+            }
+            if (captured_player(state) >= 0) break;
+            state.update_round();
+        }
+    }
+    std::printf("%d games, %lld positions, %lld operations: generator matches execute_operation, snapshots consistent\n", games, positions, total);
+    return 0;
+}
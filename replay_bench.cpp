@@ -0,0 +1,134 @@
+// 基于录像的引擎回归与吞吐测试：逐局重演录像，每回合结束后与录像比较，并测量重演速度
+// 用法：replay_bench <path>... [--reps N] [--dump FILE]
+//       replay_bench --self-test N [--seed S]
+// `path`为回放文件或目录（递归查找.rpl与评测平台的replay.json）；存在分歧时返回1，首个分歧处的局面写至标准错误或`--dump`
+// `--self-test`在生成的地图上随机对局N局并录像，检查关键帧编码往返不变、读回的录像与对局逐回合一致；存在问题时返回1
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "include/regression.hpp"
+#include "include/cli.hpp"
+#include "include/mapgen.hpp"
+#include "include/movegen.hpp"
+#include "include/simulate.hpp"
+
+// 局面经`encode_state`/`decode_state`往返后是否不变
+bool state_round_trips(const GameState& state) {
+    static const GameState blank;
+    Byte_writer out;
+    encode_state(state, out);
+    Byte_reader in(out.data.data(), out.data.size());
+    GameState decoded;
+    decoded.copy_as(blank);
+    decode_state(decoded, in);
+    return decoded.zobrist == state.zobrist && !in.remaining();
+}
+
+// 在第`game`张生成的地图上随机对局并录像，写入`path`后读回重演；返回首个问题，一致时返回空串
+std::string self_test_game(uint64_t seed, int game, const std::string& path, std::vector<Operation>& buffer,
+                           Recorded_match& match, GameState& replayed) {
+    std::mt19937_64 rng(map_seed(seed, game));
+    GameState state;
+    generate_map(state, map_seed(seed, game));
+    // 关键帧间隔取小值，使较短的对局也含多个关键帧
+    Replay_writer replay(state, 7);
+    std::vector<Operation> executed[PLAYER_COUNT];
+    int winner = -1;
+    bool settled = true;
+    for (int round = 1; round <= 300 && winner < 0; ++round) {
+        for (std::vector<Operation>& list : executed) list.clear();
+        for (int p = 0; p < PLAYER_COUNT && winner < 0; ++p) {
+            for (int i = 0, n = rng() % 8; i < n && winner < 0; ++i) {
+                int count = generate_operations(state, p, buffer.data(), buffer.size());
+                if (!count) break;
+                const Operation& op = buffer[rng() % count];
+                if (!execute_operation(state, p, op, false)) return "generated operation rejected: " + op.str();
+                executed[p].push_back(op);
+                int loser = captured_player(state);
+                if (loser >= 0) winner = 1 - loser;
+            }
+        }
+        settled = winner < 0;
+        if (settled) state.update_round();
+        if (!state_round_trips(state)) return wrap("state round trip differs after round %d", round);
+        replay.add_round(executed[0].data(), executed[0].size(), executed[1].data(), executed[1].size(), state);
+    }
+
+    save_replay(path, replay.finish(winner, !settled));
+    load_recorded_match(path, match);
+    Divergence divergence;
+    if (!verify_match(match, replayed, divergence)) return wrap("diverged at round %d: %s", divergence.round, divergence.reason.c_str());
+    if (replayed.zobrist != state.zobrist) return "final state differs";
+    return "";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <path>... [--reps N] [--dump FILE]\n       %s --self-test N [--seed S]\n", argv[0], argv[0]);
+        return 1;
+    }
+    std::vector<std::string> paths;
+    std::string dump_path;
+    int reps = 1, self_test = 0;
+    uint64_t seed = 0;
+    for (Arg_reader args(argc, argv, 1); args.next();) {
+        if (args.is("--reps")) reps = std::max(1, args.int_value());
+        else if (args.is("--dump")) dump_path = args.value();
+        else if (args.is("--self-test")) self_test = args.int_value();
+        else if (args.is("--seed")) seed = args.uint64_value();
+        else {
+            std::vector<std::string> found = find_recorded_matches(args.current());
+            paths.insert(paths.end(), found.begin(), found.end());
+        }
+    }
+
+    // 录像与局面体积较大，跨对局复用
+    static Recorded_match match;
+    static GameState state;
+    if (self_test) {
+        char path[] = "/tmp/replay_bench_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) throw std::runtime_error("Cannot create temporary file");
+        close(fd);
+        std::vector<Operation> buffer(1 << 18);
+        int failed = 0;
+        for (int game = 0; game < self_test; ++game) {
+            std::string problem = self_test_game(seed, game, path, buffer, match, state);
+            if (!problem.empty() && !failed++) std::printf("game %d (seed %llu): %s\n", game, (unsigned long long)seed, problem.c_str());
+        }
+        unlink(path);
+        std::printf("%d games, %d failed\n", self_test, failed);
+        return failed ? 1 : 0;
+    }
+    if (paths.empty()) throw std::runtime_error("No replay given");
+    Divergence divergence;
+    int diverged = 0;
+    long long rounds = 0, actions = 0;
+    double seconds = 0;
+    for (const std::string& path : paths) {
+        load_recorded_match(path, match);
+        if (!verify_match(match, state, divergence)) {
+            std::printf("%s: diverged at round %d: %s\n", path.c_str(), divergence.round, divergence.reason.c_str());
+            if (!diverged++) {
+                std::ofstream dump;
+                if (!dump_path.empty()) dump.open(dump_path);
+                show_divergence(match, state, divergence, dump_path.empty() ? std::cerr : dump);
+            }
+        }
+        for (int rep = 0; rep < reps; ++rep) seconds += time_match(match, state);
+        rounds += (long long)match.rounds.size() * reps;
+        actions += (long long)match.action_count * reps;
+    }
+
+    std::printf("%d matches, %d diverged; %lld rounds, %lld ops in %.3f s: %.0f rounds/s, %.0f ops/s\n",
+                int(paths.size()), diverged, rounds, actions, seconds, rounds / seconds, actions / seconds);
+    return diverged ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+// 本地对局器：在给定地图上让两个bot可执行文件多局对战，并行运行并记录结果
+// 用法：runner <bot_a> <bot_b> (--maps <file> | --generate N [--seed S]) [--games N] [--jobs J] [--rounds R] [--time-limit MS]
+//              [--out FILE] [--log-dir DIR] [--replay-dir DIR]
+// 地图库为`mapgen`的输出（逐行JSON或二进制）；第2k与2k+1局使用同一张地图并交换座次
+// 各局结果写为CSV，汇总写至标准错误；裁判进程异常的对局单独计数，存在时返回1
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "include/match.hpp"
+#include "include/cli.hpp"
+#include "include/mapgen.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <bot_a> <bot_b> (--maps <file> | --generate N [--seed S]) [--games N] [--jobs J] "
+                             "[--rounds R] [--time-limit MS] [--out FILE] [--log-dir DIR] [--replay-dir DIR]\n", argv[0]);
+        return 1;
+    }
+    const std::string bot_a = argv[1], bot_b = argv[2];
+    std::string map_path, out_path, log_dir, replay_dir;
+    uint64_t seed = 0;
+    int generate = 0, games = 0, jobs = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    Match_config config;
+    for (Arg_reader args(argc, argv, 3); args.next();) {
+        if (args.is("--maps")) map_path = args.value();
+        else if (args.is("--generate")) generate = args.int_value();
+        else if (args.is("--seed")) seed = args.uint64_value();
+        else if (args.is("--games")) games = args.int_value();
+        else if (args.is("--jobs")) jobs = std::max(1, args.int_value());
+        else if (args.is("--rounds")) config.max_rounds = args.int_value();
+        else if (args.is("--time-limit")) config.time_limit_ms = args.int_value();
+        else if (args.is("--out")) out_path = args.value();
+        else if (args.is("--log-dir")) log_dir = args.value();
+        else if (args.is("--replay-dir")) replay_dir = args.value();
+        else args.unknown();
+    }
+
+    std::vector<std::string> maps;
+    if (!map_path.empty()) maps = load_map_corpus(map_path);
+    for (int i = 0; i < generate; ++i) {
+        GameState state;
+        generate_map(state, map_seed(seed, i));
+        maps.push_back(init_map_json(state, 0));
+    }
+    if (maps.empty()) throw std::runtime_error("No map given");
+    // 默认每张地图交换座次各下一局
+    if (games <= 0) games = 2 * maps.size();
+
+    std::FILE* out = out_path.empty() ? stdout : std::fopen(out_path.c_str(), "w");
+    if (!out) throw std::runtime_error("Cannot open " + out_path);
+    // 转发时对方可能已退出，写入失败由返回值处理
+    signal(SIGPIPE, SIG_IGN);
+
+    // 第`game`局中bot_a的座次
+    auto seat_of_a = [](int game) { return game % 2; };
+    auto play = [&](int game) {
+        int a = seat_of_a(game);
+        std::string bots[PLAYER_COUNT], logs[PLAYER_COUNT];
+        bots[a] = bot_a, bots[1 - a] = bot_b;
+        if (!log_dir.empty()) for (int p = 0; p < PLAYER_COUNT; ++p)
+            logs[p] = log_dir + "/game" + std::to_string(game) + "_" + (p == a ? "a" : "b") + ".log";
+        std::string replay = replay_dir.empty() ? "" : replay_dir + "/game" + std::to_string(game) + ".rpl";
+        return play_match(config, maps[game / 2 % maps.size()], bots, logs, replay);
+    };
+
+    // 裁判异常的对局没有胜负，不计入平局与得分
+    int wins_a = 0, wins_b = 0, draws = 0, errors = 0;
+    std::fprintf(out, "game,map,seat_a,winner,rounds,reason\n");
+    run_matches(games, jobs, play, [&](int game, const Match_result& result) {
+        int a = seat_of_a(game);
+        bool error = result.reason == End_reason::REFEREE_ERROR;
+        const char* winner = error ? "error" : result.winner < 0 ? "draw" : result.winner == a ? "a" : "b";
+        if (error) ++errors;
+        else if (result.winner < 0) ++draws;
+        else ++(result.winner == a ? wins_a : wins_b);
+        std::fprintf(out, "%d,%d,%d,%s,%d,%s\n", game, int(game / 2 % maps.size()), a, winner, result.rounds, end_reason_str(result.reason));
+        std::fflush(out);
+    });
+    if (out != stdout) std::fclose(out);
+
+    int scored = games - errors;
+    std::fprintf(stderr, "%d games: a %d, b %d, draw %d, error %d, a score %.3f\n",
+                 games, wins_a, wins_b, draws, errors, scored ? (wins_a + 0.5 * draws) / scored : 0.0);
+    return errors ? 1 : 0;
+}